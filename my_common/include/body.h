@@ -1,31 +1,61 @@
 ﻿#ifndef COMMON_BODY_H
 #define COMMON_BODY_H
 
-#include <vector>
+#include <cstdint>
 
 #include "maths/vec2.h"
 
 namespace common {
 
+enum class BodyType : std::uint8_t {
+  kDynamic,   // mû par les forces
+  kKinematic, // mû par sa vitesse seulement, masse infinie
+  kStatic,    // ne bouge pas, jamais intégré
+};
+
+// Bits de la colonne flags
+enum BodyFlags : std::uint8_t {
+  kBodyAlive = 1 << 0,
+  kBodyAwake = 1 << 1,
+};
+
+// Vue sur un corps rangé en colonnes dans common::world (une colonne par
+// champ). Les références ne tiennent que jusqu'au prochain AddBody, qui
+// peut réallouer les colonnes : ne pas garder un Body d'une frame à l'autre.
 class Body {
 public:
-  explicit Body(float mass_init);
+  Body(core::Vec2F& position, core::Vec2F& velocity, core::Vec2F& force,
+       float& mass, float& inverse_mass, const BodyType& type,
+       const std::uint8_t& flags);
 
-  core::Vec2F position = {0,0};
-  float mass = 0.1f;
+  core::Vec2F& position;
 
   void Velocity(const core::Vec2F& vel);
   void AddForce(const core::Vec2F& force);
-  void Tick(float dt);
 
-  [[nodiscard]] core::Vec2F velocity() const {return velocity_;};
-  [[nodiscard]] bool IsInvalid() const {return mass <= 0.f;}
+  [[nodiscard]] core::Vec2F velocity() const {return velocity_;}
+  // Gardée pour les non dynamiques (gravité du Soleil), mais seuls les
+  // corps dynamiques ont une masse inverse non nulle
+  [[nodiscard]] float mass() const {return mass_;}
+  // Met aussi à jour la masse inverse utilisée par l'intégration
+  void SetMass(float mass);
+  [[nodiscard]] BodyType type() const {return type_;}
+  [[nodiscard]] bool IsInvalid() const {return (flags_ & kBodyAlive) == 0;}
 private:
 
-  core::Vec2F velocity_ = {0,0};
-  core::Vec2F accumulated_force = {0,0};
+  core::Vec2F& velocity_;
+  core::Vec2F& accumulated_force_;
+  float& mass_;
+  float& inverse_mass_;
+  const BodyType& type_;
+  const std::uint8_t& flags_;
 };
 
+// Masse inverse utilisée par l'intégration : 0 pour une masse infinie
+[[nodiscard]] inline float InverseMass(const float mass, const BodyType type) {
+  return type == BodyType::kDynamic && mass > 0.f ? 1.f / mass : 0.f;
+}
+
 } // namespace common
 
 #endif // COMMON_BODY_H
@@ -0,0 +1,94 @@
+﻿#ifndef COMMON_BROADPHASE_H
+#define COMMON_BROADPHASE_H
+
+#include <compare>
+#include <vector>
+
+#include "maths/vec2.h"
+
+namespace common::world {
+
+// Axis aligned bounding box, bornes inclusives (un contact tangent compte)
+struct Aabb {
+  core::Vec2F min = {0, 0};
+  core::Vec2F max = {0, 0};
+
+  [[nodiscard]] static constexpr Aabb FromCircle(const core::Vec2F center,
+                                                 const float radius) {
+    return {{center.x - radius, center.y - radius},
+            {center.x + radius, center.y + radius}};
+  }
+
+  [[nodiscard]] constexpr bool Overlaps(const Aabb& other) const {
+    return min.x <= other.max.x && other.min.x <= max.x &&
+           min.y <= other.max.y && other.min.y <= max.y;
+  }
+
+  [[nodiscard]] constexpr bool Contains(const Aabb& other) const {
+    return min.x <= other.min.x && min.y <= other.min.y &&
+           other.max.x <= max.x && other.max.y <= max.y;
+  }
+};
+
+// Candidate pair of proxies, always stored with a < b
+struct ProxyPair {
+  int a = -1;
+  int b = -1;
+
+  auto operator<=>(const ProxyPair&) const = default;
+};
+
+enum class BroadPhaseType {
+  kBruteForce,  // O(n^2), no acceleration structure
+  kSpatialHash,
+  kSweepAndPrune, // best when bodies barely move between ticks
+  kDynamicTree,   // best for widely varying radii
+  kLinearBvh,     // rebuilt in parallel every tick, for huge moving scenes
+  kHierarchicalGrid, // mixes of tiny and huge radii
+};
+
+// Receives the proxies found by BroadPhase::Query
+class QueryCallback {
+public:
+  // false stops the query
+  virtual bool Report(int proxy) = 0;
+
+protected:
+  ~QueryCallback() = default;
+};
+
+// QueryCallback over a callable returning bool
+template <typename Fn>
+class FunctionQueryCallback final : public QueryCallback {
+public:
+  explicit FunctionQueryCallback(Fn& fn) : fn_(fn) {}
+  bool Report(const int proxy) override { return fn_(proxy); }
+
+private:
+  Fn& fn_;
+};
+
+// A broadphase tracks one box per proxy (the collider slot) and reports the
+// pairs whose boxes may overlap. The exact circle test is done by the world.
+class BroadPhase {
+public:
+  virtual ~BroadPhase() = default;
+
+  virtual void Insert(int proxy, const Aabb& aabb) = 0;
+  virtual void Remove(int proxy) = 0;
+  // Called every tick for every live proxy, must be cheap when nothing moved
+  virtual void Move(int proxy, const Aabb& aabb) = 0;
+  // Appends every overlapping pair once, in no particular order
+  virtual void FindPairs(std::vector<ProxyPair>& pairs) = 0;
+  // Reports once every proxy whose box overlaps aabb, in no particular
+  // order. The boxes are those of the last FindPairs at worst. Only reads
+  // the structure, several threads may query at once.
+  virtual void Query(const Aabb& aabb, QueryCallback& callback) const = 0;
+  // false when Query is a pass over every box: one query per collider
+  // would then be quadratic
+  [[nodiscard]] virtual bool HasSpatialQuery() const { return true; }
+};
+
+} // namespace common::world
+
+#endif // COMMON_BROADPHASE_H
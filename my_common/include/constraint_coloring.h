@@ -0,0 +1,80 @@
+﻿#ifndef COMMON_CONSTRAINT_COLORING_H
+#define COMMON_CONSTRAINT_COLORING_H
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace common::world {
+
+// Greedy colouring of a constraint graph: each constraint, in order, takes
+// the lowest colour no earlier constraint on one of its dynamic bodies has.
+// Within a colour no two constraints share a dynamic body, so a colour
+// can be split across threads and gives the same result as solving it in
+// order. Bodies with a zero inverse mass are only read and don't count.
+inline constexpr int kMaxColors = 64;
+
+struct ConstraintColors {
+  // constraints grouped by colour, in their input order within a colour.
+  // Group g is order[offsets[g], offsets[g + 1]). The last group holds the
+  // constraints that found no free colour and must be solved on one
+  // thread, it is usually empty.
+  std::vector<int> order;
+  std::vector<int> offsets;
+  // scratch
+  std::vector<std::uint64_t> body_masks;
+  std::vector<int> colors;
+
+  [[nodiscard]] int GroupCount() const { return static_cast<int>(offsets.size()) - 1; }
+  [[nodiscard]] bool IsSerial(const int group) const { return group == GroupCount() - 1; }
+};
+
+// Constraint is anything with body slots a and b
+template <typename Constraint>
+void ColorConstraints(const std::span<const Constraint> constraints,
+                      const float* inverse_mass, const std::size_t body_count,
+                      ConstraintColors& out) {
+  out.body_masks.assign(body_count, 0);
+  out.colors.resize(constraints.size());
+  int used = 0;
+  for (std::size_t k = 0; k < constraints.size(); ++k) {
+    const int  a = constraints[k].a;
+    const int  b = constraints[k].b;
+    const bool dynamic_a = inverse_mass[a] > 0.f;
+    const bool dynamic_b = inverse_mass[b] > 0.f;
+    const std::uint64_t taken = (dynamic_a ? out.body_masks[a] : 0) |
+                                (dynamic_b ? out.body_masks[b] : 0);
+    int color = kMaxColors; // serial group
+    if (taken != ~std::uint64_t{0}) {
+      color = std::countr_one(taken);
+      const std::uint64_t bit = std::uint64_t{1} << color;
+      if (dynamic_a) out.body_masks[a] |= bit;
+      if (dynamic_b) out.body_masks[b] |= bit;
+      used = std::max(used, color + 1);
+    }
+    out.colors[k] = color;
+  }
+
+  // counting sort on the colour, the serial group last
+  out.offsets.assign(static_cast<std::size_t>(used) + 2, 0);
+  for (int& color : out.colors) {
+    if (color == kMaxColors) color = used;
+    ++out.offsets[static_cast<std::size_t>(color) + 1];
+  }
+  for (std::size_t g = 1; g < out.offsets.size(); ++g) out.offsets[g] += out.offsets[g - 1];
+  out.order.resize(constraints.size());
+  for (std::size_t k = 0; k < constraints.size(); ++k) {
+    out.order[static_cast<std::size_t>(out.offsets[static_cast<std::size_t>(out.colors[k])]++)] =
+        static_cast<int>(k);
+  }
+  // the increments moved every offset to the end of its group
+  for (std::size_t g = out.offsets.size() - 1; g > 0; --g) out.offsets[g] = out.offsets[g - 1];
+  out.offsets[0] = 0;
+}
+
+} // namespace common::world
+
+#endif // COMMON_CONSTRAINT_COLORING_H
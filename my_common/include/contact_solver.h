@@ -0,0 +1,105 @@
+﻿#ifndef COMMON_CONTACT_SOLVER_H
+#define COMMON_CONTACT_SOLVER_H
+
+#include <cstdint>
+#include <span>
+
+#include "maths/vec2.h"
+
+namespace common::world {
+
+enum class SolverType : std::uint8_t {
+  // after the integration, sequential impulses on the overlapping pairs
+  kImpulse,
+  // instead of the integration, substeps of position projection (see
+  // xpbd_solver.h). Also solves the distance constraints.
+  kXpbd,
+};
+
+// Contact response between solid colliders. kImpulse: one contact per
+// overlapping pair, solved with sequential impulses warm started from the
+// pair's impulse of last tick. More iterations settle stacks better and
+// cost more.
+struct SolverSettings {
+  SolverType type = SolverType::kImpulse;
+  // kImpulse only
+  int   velocity_iterations = 8;
+  int   position_iterations = 3;
+  float restitution = 0.f; // 1: elastic
+  // below this approach speed contacts don't bounce, resting ones jitter
+  // otherwise
+  float restitution_threshold = 1.f;
+  // fraction of the penetration removed per position iteration, and the
+  // penetration left alone so resting contacts stay touching
+  float position_correction = 0.2f;
+  float slop = 0.01f;
+  bool  warm_starting = true;
+  // kXpbd only: one projection of every constraint per substep, no
+  // restitution
+  int   substeps = 8;
+  float contact_compliance = 0.f; // inverse stiffness, 0: rigid
+};
+
+// Contact between two circles. Bodies don't rotate, the normal is all the
+// manifold needs.
+struct Contact {
+  std::uint64_t key = 0; // collider pair, finds last tick's impulse
+  int           a = 0;   // body slots
+  int           b = 0;
+  core::Vec2F   normal = {0, 0}; // from a to b
+  float         radius = 0.f;    // sum of the radii
+  float         impulse = 0.f;   // accumulated along the normal, >= 0
+};
+
+// The contacts being solved as columns, in solving order
+struct ContactSoa {
+  const int*   a = nullptr;
+  const int*   b = nullptr;
+  const float* normal_x = nullptr;
+  const float* normal_y = nullptr;
+  const float* radius = nullptr;
+  float*       normal_mass = nullptr;
+  float*       bounce = nullptr; // normal velocity asked by the restitution
+  float*       impulse = nullptr;
+};
+
+// Body columns the solver reads and writes, indexed by slot
+struct ContactBodies {
+  core::Vec2F* position = nullptr;
+  core::Vec2F* velocity = nullptr;
+  const float* inverse_mass = nullptr;
+};
+
+// Normal and radius of contact for circles at pa and pb, false if they
+// don't overlap. Concentric circles are pushed apart along x.
+[[nodiscard]] bool CircleManifold(core::Vec2F pa, float ra, core::Vec2F pb,
+                                  float rb, Contact& contact);
+
+// Contacts [first, last): effective mass and restitution target, from the
+// velocities before any impulse of the tick. Only reads the bodies.
+void PrepareContacts(const ContactBodies& bodies, const ContactSoa& contacts,
+                     int first, int last, const SolverSettings& settings);
+
+// The passes below solve contacts [first, last) in order. Only bodies with
+// a non zero inverse mass are written: a range whose contacts share no
+// such body (a colour, see constraint_coloring.h) can be split across
+// threads.
+
+// Applies the impulses kept from last tick
+void WarmStartContacts(const ContactBodies& bodies, const ContactSoa& contacts,
+                       int first, int last);
+
+// One sequential-impulse pass, 8 (AVX2) or 16 (AVX-512) contacts per
+// instruction with a scalar fallback. The contacts of a SIMD batch must
+// share no dynamic body. All paths compute the same operations, so they
+// agree bit for bit with each other.
+void SolveContactVelocities(const ContactBodies& bodies, const ContactSoa& contacts,
+                            int first, int last);
+
+// One pass removing a fraction of the penetrations on the positions
+void SolveContactPositions(const ContactBodies& bodies, const ContactSoa& contacts,
+                           int first, int last, const SolverSettings& settings);
+
+} // namespace common::world
+
+#endif // COMMON_CONTACT_SOLVER_H
@@ -0,0 +1,108 @@
+﻿#ifndef COMMON_DYNAMIC_AABB_TREE_H
+#define COMMON_DYNAMIC_AABB_TREE_H
+
+#include <cstdint>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+#include "broadphase.h"
+
+namespace common::world {
+
+// Bounding volume hierarchy holding one fattened box per proxy, in the
+// spirit of Box2D's b2DynamicTree. A leaf is only reinserted when its body
+// leaves the fat box, and the tree is kept balanced with AVL rotations, so
+// neither radii spread nor motion require a rebuild.
+class DynamicAabbTree final : public BroadPhase {
+public:
+  void Insert(int proxy, const Aabb& aabb) override;
+  void Remove(int proxy) override;
+  void Move(int proxy, const Aabb& aabb) override;
+  void FindPairs(std::vector<ProxyPair>& pairs) override;
+  void Query(const Aabb& aabb, QueryCallback& callback) const override;
+
+  // Calls fn(proxy) for every proxy whose box overlaps aabb, until fn
+  // returns false if it returns a bool. Only reads the tree, several
+  // threads may query at once.
+  template <typename Fn>
+  void Query(const Aabb& aabb, Fn&& fn) const;
+
+  [[nodiscard]] int height() const {
+    return root_ < 0 ? 0 : nodes_[root_].height;
+  }
+
+private:
+  static constexpr int kNullNode = -1;
+  // Fat margin = ratio * box size, at least kMinMargin
+  static constexpr float kMarginRatio = 0.1f;
+  static constexpr float kMinMargin = 1.f;
+  // The fat box is stretched by this many ticks of displacement
+  static constexpr float kDisplacementMultiplier = 4.f;
+  // AVL balanced: height < 1.45 log2(leaves), far below this
+  static constexpr int kMaxQueryStack = 128;
+
+  struct Node {
+    Aabb aabb;
+    int  parent = kNullNode; // next free node when unused
+    int  child1 = kNullNode;
+    int  child2 = kNullNode;
+    int  height = -1;        // leaf = 0, free node = -1
+    int  proxy = -1;
+
+    [[nodiscard]] bool IsLeaf() const { return child1 == kNullNode; }
+  };
+
+  struct Proxy {
+    Aabb aabb; // tight box given by the world
+    int  leaf = kNullNode;
+    bool moved = false;
+  };
+
+  [[nodiscard]] static std::uint64_t PairKey(int a, int b);
+  [[nodiscard]] static float Margin(const Aabb& aabb);
+  [[nodiscard]] static Aabb Fatten(const Aabb& aabb,
+                                   const core::Vec2F& displacement);
+
+  int  AllocateNode();
+  void FreeNode(int node);
+  void InsertLeaf(int leaf);
+  void RemoveLeaf(int leaf);
+  int  Balance(int a);
+
+  std::vector<Node>  nodes_;
+  int                root_ = kNullNode;
+  int                free_list_ = kNullNode;
+  std::vector<Proxy> proxies_;
+
+  std::vector<int>                  move_buffer_;
+  std::unordered_set<std::uint64_t> pairs_;
+  std::vector<int>                  stack_;
+};
+
+template <typename Fn>
+void DynamicAabbTree::Query(const Aabb& aabb, Fn&& fn) const {
+  if (root_ == kNullNode) return;
+  int stack[kMaxQueryStack];
+  int size = 0;
+  stack[size++] = root_;
+  while (size > 0) {
+    const Node& n = nodes_[stack[--size]];
+    if (!n.aabb.Overlaps(aabb)) continue;
+    if (n.IsLeaf()) {
+      if (!proxies_[n.proxy].aabb.Overlaps(aabb)) continue;
+      if constexpr (std::is_same_v<std::invoke_result_t<Fn&, int>, bool>) {
+        if (!fn(n.proxy)) return;
+      } else {
+        fn(n.proxy);
+      }
+      continue;
+    }
+    stack[size++] = n.child1;
+    stack[size++] = n.child2;
+  }
+}
+
+} // namespace common::world
+
+#endif // COMMON_DYNAMIC_AABB_TREE_H
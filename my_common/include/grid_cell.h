@@ -0,0 +1,43 @@
+﻿#ifndef COMMON_GRID_CELL_H
+#define COMMON_GRID_CELL_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace common::world::grid {
+
+// Cell coordinates are clamped so that any float maps to a valid int
+inline constexpr float kMaxCellCoord = 1 << 30;
+
+[[nodiscard]] inline int ToCell(const float v, const float inv_cell_size) {
+  float c = std::floor(v * inv_cell_size);
+  // NaN et positions absurdes finissent dans les cellules du bord
+  if (!(c > -kMaxCellCoord)) c = -kMaxCellCoord;
+  if (c > kMaxCellCoord) c = kMaxCellCoord;
+  return static_cast<int>(c);
+}
+
+[[nodiscard]] inline std::uint64_t CellKey(const int x, const int y) {
+  return static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32 |
+         static_cast<std::uint32_t>(y);
+}
+
+[[nodiscard]] inline int CellX(const std::uint64_t key) {
+  return static_cast<int>(static_cast<std::uint32_t>(key >> 32));
+}
+
+[[nodiscard]] inline int CellY(const std::uint64_t key) {
+  return static_cast<int>(static_cast<std::uint32_t>(key));
+}
+
+struct CellKeyHasher {
+  std::size_t operator()(const std::uint64_t key) const noexcept {
+    // Fibonacci hashing, the raw key has all its entropy in two halves
+    return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> 16);
+  }
+};
+
+} // namespace common::world::grid
+
+#endif // COMMON_GRID_CELL_H
@@ -0,0 +1,109 @@
+﻿#ifndef COMMON_HIERARCHICAL_GRID_H
+#define COMMON_HIERARCHICAL_GRID_H
+
+#include <cstdint>
+#include <vector>
+
+#include "broadphase.h"
+#include "grid_cell.h"
+
+namespace common::world {
+
+// Stack of grids whose cell size doubles at every level. A proxy is binned
+// once, by its center, in the first level whose cells are at least as big
+// as its box, so 1-unit particles and 50-unit planets each get a fitting
+// grid. Pairs are looked up in the 3x3 neighbourhood of the proxy's own
+// level and of the coarser occupied levels only, which bounds the
+// candidates whatever the radius spread.
+//
+// The occupied cells of every level are rebuilt each FindPairs into one
+// flat open-addressing table. Proxies are visited in Morton order, so the
+// cells sharing a coarser parent follow each other and its 3x3
+// neighbourhood is looked up once for all of them. Every level derives its
+// cell coordinates from the base level's by a shift.
+//
+// Prefer it to LinearBvh when radii span orders of magnitude, e.g. a few
+// large bodies among many small ones: each proxy only meets the cells of
+// its own size and larger. It runs on one thread, and LinearBvh builds and
+// traverses in parallel. LinearBvh is still the better pick on many cores
+// for very large scenes, for tight clusters where one cell holds many
+// proxies, and for scenes wider than 65536 base cells, where the Morton
+// order is dropped.
+class HierarchicalGrid final : public BroadPhase {
+public:
+  void Insert(int proxy, const Aabb& aabb) override;
+  void Remove(int proxy) override;
+  void Move(int proxy, const Aabb& aabb) override;
+  void FindPairs(std::vector<ProxyPair>& pairs) override;
+  void Query(const Aabb& aabb, QueryCallback& callback) const override;
+
+  [[nodiscard]] float base_cell_size() const { return base_cell_size_; }
+
+private:
+  static constexpr int kMaxLevels = 32;
+  // Base cell side = this quantile of the proxy sizes, the larger proxies
+  // go up the levels
+  static constexpr float kSizeQuantile = 0.75f;
+
+  struct Proxy {
+    Aabb aabb;
+    int  level = -1; // -1 = not sized yet
+    bool alive = false;
+    bool built = false;   // in the table of the last FindPairs
+    bool pending = false; // in unbuilt_
+  };
+
+  // Occupied cell of one level, its proxies are members_[begin, end)
+  struct Cell {
+    int x = 0;
+    int y = 0;
+    int level = 0;
+    int begin = 0;
+    int end = 0;
+  };
+
+  struct Slot {
+    std::uint64_t key = 0;
+    int           level = 0;
+    int           cell = -1; // -1 = empty
+  };
+
+  [[nodiscard]] bool NeedsResize() const;
+  [[nodiscard]] int  LevelFor(const Aabb& aabb) const;
+  // Cell of a point on the base level, the others shift it
+  [[nodiscard]] int BaseCell(float v) const {
+    return grid::ToCell(v, inv_base_cell_size_);
+  }
+  [[nodiscard]] std::size_t SlotFor(int level, std::uint64_t key) const;
+  [[nodiscard]] int FindCell(int level, int x, int y) const;
+  int  FindOrAddCell(int level, int x, int y);
+  void Build();
+  void Resize();
+
+  std::vector<Proxy> proxies_;
+  std::vector<int>   unbuilt_; // inserted since the last FindPairs
+
+  std::vector<Slot>  slots_; // power of two size
+  int                slot_shift_ = 64; // 64 - log2(size)
+  std::vector<Cell>  cells_;
+  std::vector<int>   members_;
+  std::vector<Aabb>  member_boxes_; // in members_ order
+  std::uint64_t      occupied_levels_ = 0;
+  int                level_cell_counts_[kMaxLevels] = {};
+
+  // Build scratch: Morton code << 32 | proxy
+  std::vector<std::uint64_t> keys_;
+  std::vector<std::uint64_t> sort_scratch_;
+  std::vector<int>           base_x_;
+  std::vector<int>           base_y_;
+  std::vector<int>           proxy_cells_;
+
+  float base_cell_size_ = 0.f;
+  float inv_base_cell_size_ = 0.f;
+  int   live_count_ = 0;
+  int   sized_count_ = 0; // live count when the base size was last chosen
+};
+
+} // namespace common::world
+
+#endif // COMMON_HIERARCHICAL_GRID_H
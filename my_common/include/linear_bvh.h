@@ -0,0 +1,64 @@
+﻿#ifndef COMMON_LINEAR_BVH_H
+#define COMMON_LINEAR_BVH_H
+
+#include <cstdint>
+#include <vector>
+
+#include "broadphase.h"
+#include "thread_pool.h"
+
+namespace common::world {
+
+// Linear BVH rebuilt from scratch every FindPairs, for scenes where most
+// bodies move every tick and refitting a tree is not enough. Boxes are
+// ordered along a 30-bit Morton curve with a parallel radix sort, every
+// internal node is emitted independently (Karras 2012, "Maximizing
+// parallelism in the construction of BVHs, octrees and k-d trees"), boxes
+// are refit bottom-up and the tree is traversed in parallel for pairs.
+class LinearBvh final : public BroadPhase {
+public:
+  explicit LinearBvh(ThreadPool* pool = &GetThreadPool()) : pool_(pool) {}
+
+  void Insert(int proxy, const Aabb& aabb) override;
+  void Remove(int proxy) override;
+  void Move(int proxy, const Aabb& aabb) override;
+  void FindPairs(std::vector<ProxyPair>& pairs) override;
+  void Query(const Aabb& aabb, QueryCallback& callback) const override;
+
+private:
+  struct Proxy {
+    Aabb aabb;
+    bool alive = false;
+    bool built = false;   // a leaf of the current tree
+    bool pending = false; // in unbuilt_
+  };
+
+  // Internal nodes first [0, n - 1), then the n leaves in Morton order
+  struct Node {
+    Aabb aabb;
+    int  left = -1;
+    int  right = -1;
+    int  parent = -1;
+    int  last = -1;  // last leaf (Morton rank) below this node
+    int  proxy = -1; // leaves only
+  };
+
+  void Build();
+
+  ThreadPool*        pool_;
+  std::vector<Proxy> proxies_;
+  std::vector<int>   live_;
+  std::vector<int>   unbuilt_; // inserted since the last FindPairs
+
+  // Morton code << 32 | rank in live_, unique so ties need no special case
+  std::vector<std::uint64_t> keys_;
+  std::vector<std::uint64_t> scratch_;
+  std::vector<Node>          nodes_;
+  std::vector<int>           visits_;
+
+  std::vector<std::vector<ProxyPair>> thread_pairs_;
+};
+
+} // namespace common::world
+
+#endif // COMMON_LINEAR_BVH_H
@@ -0,0 +1,44 @@
+﻿#ifndef COMMON_NARROWPHASE_H
+#define COMMON_NARROWPHASE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "broadphase.h"
+
+namespace common::world {
+
+// Circle overlap kernels over packed per-collider arrays (x, y, radius),
+// 8 (AVX2) or 16 (AVX-512) tests per instruction with a scalar fallback.
+// Results go in a bitmask of (count + 63) / 64 words, bit k of word k / 64
+// set when test k overlaps. All paths compute dx*dx + dy*dy <= r*r with
+// the same operations, so they agree bit for bit with each other.
+struct CircleSoa {
+  const float* x = nullptr;
+  const float* y = nullptr;
+  const float* radius = nullptr;
+  // motion over the tick, only read by TimeOfImpact
+  const float* dx = nullptr;
+  const float* dy = nullptr;
+};
+
+[[nodiscard]] constexpr std::size_t MaskWordCount(const std::size_t count) {
+  return (count + 63) / 64;
+}
+
+// Test k: pairs[k].a against pairs[k].b
+void OverlapPairs(const CircleSoa& circles, const ProxyPair* pairs,
+                  std::size_t count, std::uint64_t* mask);
+
+// Test k: collider i against collider first + k, for k < last - first
+void OverlapRow(const CircleSoa& circles, int i, int first, int last,
+                std::uint64_t* mask);
+
+// Swept test: a and b moved in a straight line by (dx, dy) to reach their
+// current position. Fraction of the tick in [0, 1] at which they first
+// touch, +inf if they never do.
+[[nodiscard]] float TimeOfImpact(const CircleSoa& circles, int a, int b);
+
+} // namespace common::world
+
+#endif // COMMON_NARROWPHASE_H
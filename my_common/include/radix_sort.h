@@ -0,0 +1,21 @@
+﻿#ifndef COMMON_RADIX_SORT_H
+#define COMMON_RADIX_SORT_H
+
+#include <cstdint>
+#include <vector>
+
+namespace common {
+
+class ThreadPool;
+
+// Stable LSD radix sort of keys on bits [first_bit, last_bit), 8 bits per
+// pass. Bits outside the range are carried along but not sorted on.
+// scratch is only grown, so sorting every tick does not allocate. With a
+// pool, histograms and scatters are split in one block per thread.
+void RadixSort(std::vector<std::uint64_t>& keys,
+               std::vector<std::uint64_t>& scratch, int first_bit = 0,
+               int last_bit = 64, ThreadPool* pool = nullptr);
+
+} // namespace common
+
+#endif // COMMON_RADIX_SORT_H
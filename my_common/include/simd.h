@@ -0,0 +1,42 @@
+﻿#ifndef COMMON_SIMD_H
+#define COMMON_SIMD_H
+
+// Runtime dispatch helpers. Kernels are compiled for several instruction
+// sets in the same binary with a target attribute, and the best one the
+// CPU supports is picked when they run.
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define COMMON_SIMD_X86 1
+#else
+#define COMMON_SIMD_X86 0
+#endif
+
+#if COMMON_SIMD_X86 && (defined(__clang__) || defined(__GNUC__))
+#define COMMON_TARGET_AVX2 __attribute__((target("avx2")))
+#define COMMON_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+// MSVC lets any function use the intrinsics
+#define COMMON_TARGET_AVX2
+#define COMMON_TARGET_AVX512
+#endif
+
+namespace common::simd {
+
+enum class Level {
+  kScalar,
+  kAvx2,   // 8 floats
+  kAvx512, // 16 floats
+};
+
+// Best level supported by the CPU and the OS
+[[nodiscard]] Level DetectLevel();
+
+// Level used by the kernels: the detected one, capped by SetMaxLevel
+[[nodiscard]] Level ActiveLevel();
+
+// Caps the level, to compare paths or to rule out AVX-512 downclocking
+void SetMaxLevel(Level level);
+
+} // namespace common::simd
+
+#endif // COMMON_SIMD_H
@@ -0,0 +1,64 @@
+﻿#ifndef COMMON_SPATIAL_HASH_GRID_H
+#define COMMON_SPATIAL_HASH_GRID_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "broadphase.h"
+#include "grid_cell.h"
+
+namespace common::world {
+
+// Uniform grid stored in a hash map. Each proxy is binned in every cell its
+// box touches; a pair is only reported by the first cell both share, so no
+// deduplication pass is needed. The cell size follows the radius
+// distribution and proxies are only rebinned when their cell range changes.
+class SpatialHashGrid final : public BroadPhase {
+public:
+  void Insert(int proxy, const Aabb& aabb) override;
+  void Remove(int proxy) override;
+  void Move(int proxy, const Aabb& aabb) override;
+  void FindPairs(std::vector<ProxyPair>& pairs) override;
+  void Query(const Aabb& aabb, QueryCallback& callback) const override;
+
+  [[nodiscard]] float cell_size() const { return cell_size_; }
+
+private:
+  struct CellRange {
+    int x0 = 0, y0 = 0, x1 = -1, y1 = -1; // vide par défaut
+
+    bool operator==(const CellRange&) const = default;
+  };
+
+  struct Proxy {
+    Aabb      aabb;
+    CellRange cells;
+    bool      alive = false;
+    bool      large = false; // too many cells, tested against everyone
+  };
+
+  // Past this many cells a proxy is cheaper to test against every other one
+  static constexpr int kMaxCellsPerProxy = 64;
+  // Cell side = this quantile of the proxy sizes
+  static constexpr float kSizeQuantile = 0.75f;
+
+  [[nodiscard]] bool NeedsResize() const;
+  [[nodiscard]] CellRange ComputeRange(const Aabb& aabb) const;
+  void Bin(int proxy);
+  void Unbin(int proxy);
+  void Resize();
+
+  std::vector<Proxy> proxies_;
+  std::vector<int>   large_proxies_;
+  std::unordered_map<std::uint64_t, std::vector<int>, grid::CellKeyHasher> cells_;
+
+  float cell_size_ = 0.f;
+  float inv_cell_size_ = 0.f;
+  int   live_count_ = 0;
+  int   sized_count_ = 0; // live count when the cell size was last chosen
+};
+
+} // namespace common::world
+
+#endif // COMMON_SPATIAL_HASH_GRID_H
@@ -0,0 +1,66 @@
+﻿#ifndef COMMON_SWEEP_AND_PRUNE_H
+#define COMMON_SWEEP_AND_PRUNE_H
+
+#include <array>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+#include "broadphase.h"
+
+namespace common::world {
+
+// Incremental sort-and-sweep. The min/max endpoints of every box are kept
+// sorted on both axes with an insertion sort; since bodies barely move
+// between fixed steps only a few endpoints swap, and each swap directly
+// adds or removes a pair from the persistent overlap set.
+class SweepAndPrune final : public BroadPhase {
+public:
+  void Insert(int proxy, const Aabb& aabb) override;
+  void Remove(int proxy) override;
+  void Move(int proxy, const Aabb& aabb) override;
+  void FindPairs(std::vector<ProxyPair>& pairs) override;
+  void Query(const Aabb& aabb, QueryCallback& callback) const override;
+  [[nodiscard]] bool HasSpatialQuery() const override { return false; }
+
+private:
+  struct Endpoint {
+    float         value = 0.f;
+    std::uint32_t data = 0; // proxy << 1 | is_max
+
+    [[nodiscard]] int  proxy() const { return static_cast<int>(data >> 1); }
+    [[nodiscard]] bool is_max() const { return (data & 1u) != 0; }
+  };
+
+  struct Proxy {
+    Aabb aabb;
+    bool alive = false;
+    bool in_axes = false; // endpoints still present in the sorted lists
+  };
+
+  // Min before max on ties so that touching boxes count as overlapping
+  [[nodiscard]] static bool Less(const Endpoint& a, const Endpoint& b) {
+    return a.value < b.value ||
+           (a.value == b.value && !a.is_max() && b.is_max());
+  }
+
+  [[nodiscard]] static std::uint64_t PairKey(int a, int b);
+
+  void Purge();
+  void Refresh();
+  void SortAxis(int axis);
+  void Rebuild();
+
+  std::vector<Proxy>                    proxies_;
+  std::array<std::vector<Endpoint>, 2>  axes_;
+  std::unordered_set<std::uint64_t>     pairs_;
+  std::vector<int>                      active_; // used by Rebuild
+
+  int  live_count_ = 0;
+  int  inserted_count_ = 0; // since the last sort
+  bool has_removed_ = false;
+};
+
+} // namespace common::world
+
+#endif // COMMON_SWEEP_AND_PRUNE_H
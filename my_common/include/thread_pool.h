@@ -0,0 +1,70 @@
+﻿#ifndef COMMON_THREAD_POOL_H
+#define COMMON_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace common {
+
+// Fixed set of worker threads running data parallel loops. The calling
+// thread takes part in the loop and chunks are claimed through an atomic
+// counter, so uneven chunks balance themselves.
+class ThreadPool {
+public:
+  // (begin, end, thread), thread is 0 for the caller and 1..n for workers
+  using RangeFunction = std::function<void(int, int, int)>;
+
+  // worker_count threads are spawned on top of the caller
+  explicit ThreadPool(int worker_count = DefaultWorkerCount());
+  ~ThreadPool();
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  [[nodiscard]] static int DefaultWorkerCount();
+
+  // Threads taking part in a ParallelFor, the caller included. Per-thread
+  // buffers indexed by the thread argument need this many entries.
+  [[nodiscard]] int thread_count() const {
+    return static_cast<int>(workers_.size()) + 1;
+  }
+
+  // Calls fn on consecutive chunks of at most grain items covering
+  // [0, count) and blocks until all of them are done. A nested call, or a
+  // call made while another thread uses the pool, runs on the caller only.
+  // If fn throws, the chunks not yet claimed are skipped and the first
+  // exception is rethrown here once every thread has left the loop.
+  void ParallelFor(int count, int grain, const RangeFunction& fn);
+
+private:
+  void WorkerLoop(int thread);
+  void RunChunks(int thread);
+
+  std::vector<std::thread> workers_;
+  std::mutex               mutex_;
+  std::condition_variable  wake_;
+  std::condition_variable  done_;
+  std::atomic<bool>        busy_{false};
+
+  // Current job, only written under mutex_ while no worker runs it
+  const RangeFunction* job_ = nullptr;
+  int                  count_ = 0;
+  int                  grain_ = 1;
+  std::atomic<int>     next_{0};
+  int                  pending_ = 0;
+  std::uint64_t        generation_ = 0;
+  std::exception_ptr   error_; // first throw of the current job
+  bool                 stop_ = false;
+};
+
+// Pool shared by the world passes
+[[nodiscard]] ThreadPool& GetThreadPool();
+
+} // namespace common
+
+#endif // COMMON_THREAD_POOL_H
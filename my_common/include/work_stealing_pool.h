@@ -0,0 +1,67 @@
+﻿#ifndef COMMON_WORK_STEALING_POOL_H
+#define COMMON_WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace common {
+
+// Independent tasks run by worker threads that each own a deque. A worker
+// runs its newest task first and, once its deque is empty, steals the
+// oldest task of another worker, so runs of very different lengths still
+// keep every core busy. Unlike ThreadPool the caller doesn't take part.
+class WorkStealingPool {
+public:
+  using Task = std::function<void()>;
+
+  explicit WorkStealingPool(int thread_count = DefaultThreadCount());
+  // Waits for the queued tasks
+  ~WorkStealingPool();
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  [[nodiscard]] static int DefaultThreadCount();
+
+  [[nodiscard]] int thread_count() const {
+    return static_cast<int>(workers_.size());
+  }
+
+  // From a worker the task goes on its own deque, otherwise the deques are
+  // filled in turn
+  void Submit(Task task);
+
+  // Blocks until every submitted task ran, then rethrows the first
+  // exception a task threw, if any
+  void Wait();
+
+private:
+  struct Queue {
+    std::mutex      mutex;
+    std::deque<Task> tasks;
+  };
+
+  bool TryPop(int thread, Task& task);
+  void WorkerLoop(int thread);
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread>            workers_;
+  std::mutex                          mutex_;
+  std::condition_variable             wake_;
+  std::condition_variable             idle_;
+  std::atomic<int>                    queued_{0};  // in a deque
+  std::atomic<int>                    pending_{0}; // submitted, not done
+  std::atomic<unsigned>               next_queue_{0};
+  std::exception_ptr                  error_;
+  bool                                stop_ = false;
+};
+
+} // namespace common
+
+#endif // COMMON_WORK_STEALING_POOL_H
@@ -2,11 +2,21 @@
 #define CORE_WORLD_H
 
 #include "body.h"
+#include "broadphase.h"
+#include "constraint_coloring.h"
+#include "contact_solver.h"
+#include "xpbd_solver.h"
+#include "dynamic_aabb_tree.h"
+#include "integration.h"
 #include "container/indexed_container.h"
+#include <cstdint>
+#include <memory>
+#include <span>
 #include <unordered_set>
 #include <vector>
 #include <functional>
 #include "maths/vec2.h"
+#include "thread_pool.h"
 
 namespace common::world {
 
@@ -19,20 +29,38 @@ struct ColliderPairHasher;
 using BodyIndex = core::Index<Body>;
 using ColliderIndex = core::Index<int>; // indices simples pour les colliders
 
-// Body management
-[[nodiscard]] BodyIndex AddBody(float mass);
-[[nodiscard]] Body& get_body_at(BodyIndex body_index);
-void RemoveBody(BodyIndex body_index);
-void Tick(float dt);
+// Initial state of a body for AddBodies
+struct BodyDesc {
+  float       mass = 1.f;
+  core::Vec2F position = {0, 0};
+  core::Vec2F velocity = {0, 0};
+  BodyType    type = BodyType::kDynamic;
+};
 
 // Collider & trigger API
 struct Circle {
   float radius = 1.f;
 };
 
+// Two colliders are tested only if each one's category is in the other's
+// mask. By default everything collides with everything.
+struct CollisionFilter {
+  std::uint32_t category = 1u;
+  std::uint32_t mask = 0xFFFFFFFFu;
+
+  bool operator==(const CollisionFilter&) const = default;
+};
+
+[[nodiscard]] constexpr bool ShouldCollide(const CollisionFilter& a,
+                                           const CollisionFilter& b) {
+  return (a.category & b.mask) != 0 && (b.category & a.mask) != 0;
+}
+
 struct Collider {
   BodyIndex body{-1}; // invalide par défaut
   Circle circle;
+  CollisionFilter filter; // may be changed in place, applied next tick
+  bool solid = false; // pushes the other solid colliders away, else trigger only
 
   Collider() = default; // constructeur par défaut explicite
 };
@@ -51,24 +79,580 @@ struct ColliderPairHasher {
     int ai = p.a.index();
     int bi = p.b.index();
     if (ai > bi) std::swap(ai, bi);
-    return std::hash<int>()(ai) ^ (std::hash<int>()(bi) << 1);
+    // packed 64-bit key through a multiply-xorshift mix, xoring two small
+    // ints collided for most neighbouring pairs
+    std::uint64_t key = static_cast<std::uint64_t>(static_cast<std::uint32_t>(ai)) << 32 |
+                        static_cast<std::uint32_t>(bi);
+    key *= 0x9E3779B97F4A7C15ull;
+    return static_cast<std::size_t>(key ^ (key >> 32));
   }
 };
 
+// One trigger transition, a.index() < b.index()
+struct ContactEvent {
+  ColliderIndex a;
+  ColliderIndex b;
+};
+
+// Events of one tick, each list sorted by (a, b)
+struct ContactEvents {
+  std::span<const ContactEvent> enters;
+  std::span<const ContactEvent> stays; // empty unless stay events are on
+  std::span<const ContactEvent> exits;
+};
+
+// Owning version, filled by the world during Tick
+struct ContactEventBuffer {
+  std::vector<ContactEvent> enters;
+  std::vector<ContactEvent> stays;
+  std::vector<ContactEvent> exits;
+
+  void Clear() {
+    enters.clear();
+    stays.clear();
+    exits.clear();
+  }
+
+  [[nodiscard]] ContactEvents View() const { return {enters, stays, exits}; }
+};
+
 // Contact listener interface
 class ContactListener {
 public:
   virtual ~ContactListener() = default;
-  virtual void OnTriggerEnter(ColliderIndex a, ColliderIndex b) = 0;
-  virtual void OnTriggerExit(ColliderIndex a, ColliderIndex b) = 0;
+  // Called once at the end of every Tick with all of its events. By
+  // default forwards them one by one to the per-pair functions, enters
+  // first.
+  virtual void OnContactEvents(const ContactEvents& events);
+  virtual void OnTriggerEnter(ColliderIndex /*a*/, ColliderIndex /*b*/) {}
+  virtual void OnTriggerExit(ColliderIndex /*a*/, ColliderIndex /*b*/) {}
+};
+
+// Optional veto on the pairs the filter bits let through, asked before the
+// distance test. A pair of two sleeping or static colliders keeps its last
+// answer until one of them moves.
+class ContactFilter {
+public:
+  virtual ~ContactFilter() = default;
+  virtual bool ShouldCollide(ColliderIndex a, ColliderIndex b) = 0;
+};
+
+struct ColliderDesc {
+  BodyIndex       body{-1};
+  float           radius = 1.f;
+  CollisionFilter filter;
+  bool            solid = false;
+};
+
+// Keeps two bodies length apart, only solved by SolverType::kXpbd.
+// compliance is the inverse stiffness, 0 for a rigid rod.
+struct DistanceConstraintDesc {
+  BodyIndex a{-1};
+  BodyIndex b{-1};
+  float     length = 1.f;
+  float     compliance = 0.f;
+};
+
+using DistanceConstraintIndex = core::Index<DistanceConstraintDesc>;
+
+// A body whose speed and accumulated force stay under the thresholds for
+// ticks_to_sleep ticks is ready to sleep. Bodies linked by overlapping
+// colliders or by a distance constraint form an island, which falls asleep
+// once all of its bodies are ready and wakes as a whole. A sleeping body
+// isn't integrated and pairs of sleeping colliders keep their state without
+// being tested. It wakes when given a force, a velocity or a new position,
+// when it touches an awake body or when a body it is constrained to wakes.
+// Off by default.
+struct SleepSettings {
+  bool  enabled = false;
+  float linear_velocity = 0.05f;
+  float force = 0.05f;
+  int   ticks_to_sleep = 30;
+};
+
+// Segment from origin to end
+struct Ray {
+  core::Vec2F origin = {0, 0};
+  core::Vec2F end = {0, 0};
+};
+
+struct RayCastHit {
+  ColliderIndex collider{-1}; // -1: nothing hit
+  core::Vec2F   point = {0, 0};
+  core::Vec2F   normal = {0, 0};
+  float         fraction = 1.f; // 0 at origin, 1 at end
+};
+
+// Collider categories a query looks for
+inline constexpr std::uint32_t kAllCategories = 0xFFFFFFFFu;
+
+// One simulation: bodies, colliders, trigger pairs and listener. Worlds
+// share nothing, several can tick at once on different threads. Their
+// parallel passes go through pool, a pool busy with another world runs the
+// work on the calling thread instead.
+class World {
+public:
+  explicit World(ThreadPool& pool = GetThreadPool());
+  ~World();
+  World(const World&) = delete;
+  World& operator=(const World&) = delete;
+
+  // Body management
+  [[nodiscard]] BodyIndex AddBody(float mass, BodyType type = BodyType::kDynamic);
+  // Bulk versions: handle k of out is for descs[k], out must be at least as
+  // large as descs
+  void AddBodies(std::span<const BodyDesc> descs, std::span<BodyIndex> out);
+  // Body is a view into the world columns, valid until the next AddBody
+  [[nodiscard]] Body GetBodyAt(BodyIndex body_index);
+  void RemoveBody(BodyIndex body_index);
+  void RemoveBodies(std::span<const BodyIndex> bodies);
+  // A static body stops, its colliders move to the static partition
+  void SetBodyType(BodyIndex body_index, BodyType type);
+  void Tick(float dt);
+
+  // Turning sleep off wakes every body
+  void SetSleepSettings(const SleepSettings& settings);
+  [[nodiscard]] const SleepSettings& GetSleepSettings() const { return sleep_; }
+  [[nodiscard]] bool IsAwake(BodyIndex body_index) const;
+  void WakeBody(BodyIndex body_index);
+
+  // Solid pairs still report their trigger events. The constraints are
+  // coloured so that none of a colour share a dynamic body, each colour is
+  // solved in parallel: the result doesn't depend on the thread count.
+  void SetSolverSettings(const SolverSettings& settings) { solver_ = settings; }
+  [[nodiscard]] const SolverSettings& GetSolverSettings() const { return solver_; }
+
+  // Collider functions
+  [[nodiscard]] ColliderIndex AddCollider(BodyIndex body, float radius,
+                                          const CollisionFilter& filter = {});
+  void AddColliders(std::span<const ColliderDesc> descs, std::span<ColliderIndex> out);
+  [[nodiscard]] Collider& GetColliderAt(ColliderIndex idx);
+  void RemoveCollider(ColliderIndex idx);
+  void RemoveColliders(std::span<const ColliderIndex> idxs);
+
+  // A constraint on a removed body is skipped until it is removed too
+  [[nodiscard]] DistanceConstraintIndex AddDistanceConstraint(const DistanceConstraintDesc& desc);
+  void RemoveDistanceConstraint(DistanceConstraintIndex idx);
+
+  // Trigger state of the last Tick, O(1). A collider added since then
+  // overlaps nothing yet. The span is sorted by index and valid until
+  // the next Tick.
+  [[nodiscard]] bool IsOverlapping(ColliderIndex idx) const;
+  [[nodiscard]] int OverlapCount(ColliderIndex idx) const;
+  [[nodiscard]] std::span<const ColliderIndex> GetOverlaps(ColliderIndex idx) const;
+
+  // Spatial queries through the active broadphase, on the colliders whose
+  // category shares a bit with categories. The boxes are those of the
+  // last Tick, the exact tests use the current positions. They write at
+  // most out.size() colliders and return how many. Nothing is allocated
+  // or modified: several threads may query at once between two Ticks.
+  [[nodiscard]] int QueryAABB(const Aabb& aabb, std::span<ColliderIndex> out,
+                              std::uint32_t categories = kAllCategories) const;
+  [[nodiscard]] int QueryCircle(core::Vec2F center, float radius,
+                                std::span<ColliderIndex> out,
+                                std::uint32_t categories = kAllCategories) const;
+  [[nodiscard]] int QueryPoint(core::Vec2F point, std::span<ColliderIndex> out,
+                               std::uint32_t categories = kAllCategories) const;
+  // Closest collider crossed by the ray. A ray starting inside a circle
+  // doesn't hit it.
+  bool Raycast(const Ray& ray, RayCastHit& hit,
+               std::uint32_t categories = kAllCategories) const;
+  // Batches spread on the world's pool. Box k writes into the k-th of
+  // boxes.size() equal slices of out and its count into counts[k].
+  void QueryAABBs(std::span<const Aabb> boxes, std::span<ColliderIndex> out,
+                  std::span<int> counts,
+                  std::uint32_t categories = kAllCategories) const;
+  void Raycasts(std::span<const Ray> rays, std::span<RayCastHit> hits,
+                std::uint32_t categories = kAllCategories) const;
+  // The out.size() colliders whose centers are closest to point, closest
+  // first. Returns how many were found.
+  [[nodiscard]] int KNearest(core::Vec2F point, std::span<ColliderIndex> out,
+                             std::uint32_t categories = kAllCategories) const;
+  // Calls fn(a, b) once for every pair of colliders whose centers are at
+  // most radius apart, in no particular order
+  template <typename Fn>
+  void ForEachNeighborPair(float radius, Fn&& fn,
+                           std::uint32_t categories = kAllCategories) const;
+  // Same on the pool with fn(thread, a, b), thread in [0, ThreadCount()):
+  // fn may fill per-thread buffers without locking
+  template <typename Fn>
+  void ForEachNeighborPairParallel(float radius, Fn&& fn,
+                                   std::uint32_t categories = kAllCategories) const;
+  [[nodiscard]] int ThreadCount() const { return pool_->thread_count(); }
+
+  void SetContactListener(ContactListener* l);
+  void SetContactFilter(ContactFilter* f);
+  // Off by default: a stay event per overlapping pair and tick
+  void SetStayEvents(bool enabled);
+  // Off by default. A collider moving more than its radius in a tick is
+  // swept from where its velocity says it came from: its broadphase box
+  // covers the whole motion, and its pairs overlap if they touched at any
+  // time during the tick instead of only at its end.
+  void SetContinuousCollision(bool enabled);
+  // Last tick's events, valid until the next Tick
+  [[nodiscard]] ContactEvents GetContactEvents() const { return events_.View(); }
+  // Swaps last tick's events into out, whose storage the next Tick
+  // reuses: a consumer thread can be handed the buffer without a copy
+  void DrainContactEvents(ContactEventBuffer& out);
+
+  // Routed events: besides the global listener, a subscribed listener
+  // gets once per tick only the events involving its colliders, or a
+  // collider whose category shares a bit with categories. A removed
+  // collider's subscriptions last until its exit events are delivered.
+  void Subscribe(ColliderIndex collider, ContactListener* listener);
+  void SubscribeCategories(std::uint32_t categories, ContactListener* listener);
+  void Unsubscribe(ContactListener* listener);
+
+  // Broadphase used by the trigger pass, kSpatialHash by default.
+  // Switching rebuilds the structure from the live colliders.
+  void SetBroadPhase(BroadPhaseType type);
+  [[nodiscard]] BroadPhaseType GetBroadPhase() const;
+
+private:
+  // Colliders sharing a filter. Each layer has its own broadphase, and a
+  // pair of layers whose bits don't match is never enumerated. Meant for
+  // a handful of filters, layers are never freed.
+  struct Layer {
+    CollisionFilter             filter;
+    std::unique_ptr<BroadPhase> broad_phase; // null if it ignores itself
+    std::vector<int>            members; // moving members, per tick
+  };
+
+  // A subscribed listener and the events routed to it this tick
+  struct Route {
+    ContactListener*   listener = nullptr;
+    ContactEventBuffer events;
+    std::uint64_t      stamp = 0; // last event routed, avoids duplicates
+  };
+
+  int  BodySlot(BodyIndex body_index, const char* what) const;
+  std::size_t GrowBodies(std::size_t count);
+  std::size_t AllocateBody();
+  void WriteBody(std::size_t slot, const BodyDesc& desc);
+  void FreeBody(int slot);
+  void WakeSlot(int slot);
+  [[nodiscard]] bool IsStatic(int slot) const {
+    return body_types_[slot] == BodyType::kStatic;
+  }
+  [[nodiscard]] bool IsAsleep(int slot) const;
+
+  int  ColliderSlot(ColliderIndex idx, const char* what) const;
+  int  AllocateCollider();
+  ColliderIndex WriteCollider(int slot, const ColliderDesc& desc);
+  void FreeCollider(int slot);
+  void ForgetCollider(int slot);
+  [[nodiscard]] ColliderIndex HandleOf(int slot) const;
+  [[nodiscard]] Aabb ColliderAabb(const Collider& c) const;
+  int  LayerOf(const CollisionFilter& filter);
+  void SetLayer(int slot);
+  // Static tree for the colliders of static bodies, else their layer's
+  // broadphase
+  [[nodiscard]] BroadPhase* PartitionOf(int slot) const;
+  // circle at its packed position, grown by this tick's motion
+  [[nodiscard]] Aabb SweptAabb(int slot) const;
+  void FindCrossLayerPairs();
+  // Calls fn(slot) for every live collider of the categories whose box
+  // overlaps aabb, until fn returns false
+  template <typename Fn>
+  void ForEachCandidate(const Aabb& aabb, std::uint32_t categories, Fn&& fn) const;
+  template <typename Fn>
+  void ForEachNeighborOf(int slot, float radius, std::uint32_t categories, Fn& fn) const;
+  template <typename Test>
+  int Collect(const Aabb& aabb, std::span<ColliderIndex> out,
+              std::uint32_t categories, Test&& test) const;
+  int  RouteOf(ContactListener* listener);
+  void BuildRoutes();
+  void RouteEvents();
+
+  void UpdateAwakeSpans();
+  void FindOverlaps(float dt);
+  void MergeFrozenPairs();
+  void SolveContacts();
+  // calls fn(first, last) on ranges of the groups of colors, one group
+  // after the other
+  template <typename Fn>
+  void ForEachColorBatch(const ConstraintColors& colors, Fn&& fn);
+  void StepXpbd(float dt);
+  void FindXpbdContacts(float dt, const float* weights);
+  void UpdateIslands();
+  // unions in island_parent_ the two bodies of every live constraint
+  void UniteConstrainedBodies();
+  void DispatchEvents();
+  void UpdateOverlapTable();
+
+  // queries per chunk, a query weighs far more than an item of the
+  // per-body passes
+  static constexpr int kQueryGrain = 64;
+  // constraints per chunk of a colour, whole SIMD batches
+  static constexpr int kColorGrain = 256;
+
+  ThreadPool* pool_;
+
+  // bodies, one column per field (see Body). Hot columns are streamed by
+  // the integration, cold ones are only read on add/remove/lookup
+  std::vector<core::Vec2F> body_positions_;
+  std::vector<core::Vec2F> body_velocities_;
+  std::vector<core::Vec2F> body_forces_;
+  std::vector<float> body_inverse_masses_; // 0 for a dead slot
+  // cold
+  std::vector<float> body_masses_; // <= 0 for a dead slot
+  std::vector<int> body_generations_;
+  std::vector<BodyType> body_types_;
+  std::vector<std::uint8_t> body_flags_; // BodyFlags
+  std::vector<int> body_quiet_ticks_;    // ticks under the sleep thresholds
+  // dead slots form a LIFO list: head, then body_next_free_[slot] until -1
+  std::vector<int> body_next_free_;
+  int body_free_head_ = -1;
+
+  // colliders storage: stores Collider + generation int (similar to bodies)
+  std::vector<std::pair<Collider, int>> colliders_;
+  int live_collider_count_ = 0;
+  // same LIFO list of dead slots as the bodies
+  std::vector<int> collider_next_free_;
+  int collider_free_head_ = -1;
+
+  // active overlapping pairs, sorted packed keys (a << 32 | b, a < b)
+  std::vector<std::uint64_t> active_pairs_;
+  // this tick's pairs, swapped/cleared instead of reallocated
+  std::vector<std::uint64_t> new_pairs_;
+  std::vector<std::uint64_t> pair_scratch_;
+
+  // active_pairs_ as adjacency lists: the overlaps of slot i are
+  // overlap_ids_[overlap_offsets_[i], overlap_offsets_[i + 1])
+  std::vector<int> overlap_offsets_;
+  std::vector<ColliderIndex> overlap_ids_;
+  std::vector<int> overlap_generations_; // of each slot when built
+  std::vector<int> overlap_cursor_;
+
+  ContactListener* listener_ = nullptr;
+  ContactEventBuffer events_;
+  bool stay_events_ = false;
+  bool continuous_ = false;
+
+  // subscriptions, and the routing table built from them when they change:
+  // route ids per collider slot and per layer, as offsets + ids
+  std::vector<Route> routes_;
+  std::vector<std::pair<ColliderIndex, int>> collider_subscriptions_;
+  std::vector<std::pair<std::uint32_t, int>> category_subscriptions_;
+  std::vector<int> collider_route_offsets_;
+  std::vector<int> collider_route_ids_;
+  std::vector<int> collider_route_generations_; // of the subscribed handle
+  std::vector<int> layer_route_offsets_;
+  std::vector<int> layer_route_ids_;
+  std::vector<int> routed_layers_; // per slot at the last Tick, for removed colliders
+  std::uint64_t route_stamp_ = 0;
+  bool routes_dirty_ = false;
+  bool prune_subscriptions_ = false; // a subscribed collider was removed
+
+  SleepSettings sleep_;
+  // runs of awake non static bodies integrated this tick
+  std::vector<BodySpan> awake_spans_;
+  int static_count_ = 0;
+  // islands: union-find over the bodies of the overlapping pairs
+  std::vector<int> island_parent_;
+  std::vector<std::uint8_t> island_ready_;
+
+  // contacts of the solid pairs, sorted by key. Last tick's are kept to
+  // warm start the pairs still touching.
+  SolverSettings solver_;
+  bool any_solid_ = false;
+  std::vector<Contact> contacts_;
+  std::vector<Contact> previous_contacts_;
+  ConstraintColors contact_colors_;
+  ConstraintColors distance_colors_;
+  // kImpulse: contacts_ in colour order, as columns for the SIMD batches
+  struct ContactColumns {
+    std::vector<int>   a;
+    std::vector<int>   b;
+    std::vector<float> normal_x;
+    std::vector<float> normal_y;
+    std::vector<float> radius;
+    std::vector<float> normal_mass;
+    std::vector<float> bounce;
+    std::vector<float> impulse;
+  };
+  ContactColumns contact_columns_;
+  std::vector<Contact> contact_scratch_;
+
+  // distance constraints, a dead one has a negative body a. Same LIFO list
+  // of dead slots as the bodies.
+  std::vector<std::pair<DistanceConstraintDesc, int>> distance_constraints_;
+  std::vector<int> distance_next_free_;
+  int distance_free_head_ = -1;
+  // kXpbd, rebuilt every tick
+  std::vector<DistanceConstraint> xpbd_distances_;
+  std::vector<DistanceConstraint> xpbd_distance_scratch_;
+  std::vector<core::Vec2F> xpbd_previous_;
+  std::vector<float> xpbd_weights_; // inverse masses, 0 when asleep
+  std::vector<std::vector<Contact>> xpbd_thread_contacts_;
+
+  BroadPhaseType broad_phase_type_ = BroadPhaseType::kSpatialHash;
+  std::vector<Layer> layers_;
+  // -1 until first used, a dead slot keeps its last layer to route its
+  // exit events
+  std::vector<int> collider_layers_;
+  ContactFilter* contact_filter_ = nullptr;
+  // static colliders, only touched when one is added, removed or moved
+  std::unique_ptr<DynamicAabbTree> static_tree_;
+  // reused every tick to avoid reallocating the candidate list
+  std::vector<ProxyPair> candidate_pairs_;
+  std::vector<std::uint64_t> candidate_keys_;
+  std::vector<std::uint64_t> sort_scratch_;
+
+  // collider positions and radii packed once per tick for the narrowphase
+  std::vector<float> collider_x_;
+  std::vector<float> collider_y_;
+  std::vector<float> collider_radius_;
+  Aabb center_bounds_; // of the centers above, KNearest's first guess
+  // swept colliders' motion this tick, 0 for the others
+  std::vector<float> collider_dx_;
+  std::vector<float> collider_dy_;
+  std::vector<int> swept_slots_; // increasing
+  // swept boxes of the layers' members, for the pairs across layers
+  std::vector<Aabb> cross_boxes_;
+  // not moved since last tick: asleep or static
+  std::vector<std::uint8_t> collider_frozen_;
+  std::vector<std::uint8_t> collider_static_;
+  std::vector<std::uint64_t> frozen_pairs_;
+  std::vector<std::uint64_t> overlap_mask_;
 };
 
+template <typename Fn>
+void World::ForEachCandidate(const Aabb& aabb, const std::uint32_t categories,
+                             Fn&& fn) const {
+  // Every live collider is in exactly one partition: the static tree, its
+  // layer's broadphase, or none when the layer ignores itself or the
+  // broadphase is brute force
+  bool stopped = false;
+  auto report = [&](const int slot) {
+    const Collider& c = colliders_[slot].first;
+    if (c.body.index() < 0 || (c.filter.category & categories) == 0) return true;
+    stopped = !fn(slot);
+    return !stopped;
+  };
+  FunctionQueryCallback callback(report);
+  bool any_unindexed = false;
+  for (const Layer& layer : layers_) {
+    if ((layer.filter.category & categories) == 0) continue;
+    if (!layer.broad_phase) {
+      any_unindexed = true;
+      continue;
+    }
+    layer.broad_phase->Query(aabb, callback);
+    if (stopped) return;
+  }
+  if (static_count_ > 0) {
+    static_tree_->Query(aabb, report);
+    if (stopped) return;
+  }
+  if (!any_unindexed) return;
+  for (int i = 0; i < static_cast<int>(colliders_.size()); ++i) {
+    const Collider& c = colliders_[i].first;
+    if (c.body.index() < 0 || IsStatic(c.body.index())) continue;
+    if (layers_[collider_layers_[i]].broad_phase) continue;
+    if (!aabb.Overlaps(ColliderAabb(c))) continue;
+    if (!report(i)) return;
+  }
+}
+
+template <typename Fn>
+void World::ForEachNeighborOf(const int slot, const float radius,
+                              const std::uint32_t categories, Fn& fn) const {
+  // a pair is reported from its lower slot only
+  const Collider& c = colliders_[slot].first;
+  if (c.body.index() < 0 || (c.filter.category & categories) == 0) return;
+  const core::Vec2F center     = body_positions_[c.body.index()];
+  const float       radius_sqr = radius * radius;
+  ForEachCandidate(Aabb::FromCircle(center, radius), categories, [&](const int other) {
+    if (other <= slot) return true;
+    const core::Vec2F d = body_positions_[colliders_[other].first.body.index()] - center;
+    if (d.x * d.x + d.y * d.y <= radius_sqr) fn(HandleOf(slot), HandleOf(other));
+    return true;
+  });
+}
+
+template <typename Fn>
+void World::ForEachNeighborPair(const float radius, Fn&& fn,
+                                const std::uint32_t categories) const {
+  for (int i = 0; i < static_cast<int>(colliders_.size()); ++i) {
+    ForEachNeighborOf(i, radius, categories, fn);
+  }
+}
+
+template <typename Fn>
+void World::ForEachNeighborPairParallel(const float radius, Fn&& fn,
+                                        const std::uint32_t categories) const {
+  pool_->ParallelFor(static_cast<int>(colliders_.size()), kQueryGrain,
+                     [&](const int begin, const int end, const int thread) {
+                       auto with_thread = [&](const ColliderIndex a, const ColliderIndex b) {
+                         fn(thread, a, b);
+                       };
+                       for (int i = begin; i < end; ++i) {
+                         ForEachNeighborOf(i, radius, categories, with_thread);
+                       }
+                     });
+}
+
+// World used by the free functions below
+[[nodiscard]] World& GetDefaultWorld();
+
+// Body management
+[[nodiscard]] BodyIndex AddBody(float mass, BodyType type = BodyType::kDynamic);
+void AddBodies(std::span<const BodyDesc> descs, std::span<BodyIndex> out);
+[[nodiscard]] Body get_body_at(BodyIndex body_index);
+void RemoveBody(BodyIndex body_index);
+void RemoveBodies(std::span<const BodyIndex> bodies);
+void SetBodyType(BodyIndex body_index, BodyType type);
+void Tick(float dt);
+
+void SetSleepSettings(const SleepSettings& settings);
+[[nodiscard]] const SleepSettings& GetSleepSettings();
+void SetSolverSettings(const SolverSettings& settings);
+[[nodiscard]] const SolverSettings& GetSolverSettings();
+[[nodiscard]] bool IsAwake(BodyIndex body_index);
+void WakeBody(BodyIndex body_index);
+
 // Collider functions
-[[nodiscard]] ColliderIndex AddCollider(BodyIndex body, float radius);
+[[nodiscard]] ColliderIndex AddCollider(BodyIndex body, float radius,
+                                        const CollisionFilter& filter = {});
+void AddColliders(std::span<const ColliderDesc> descs, std::span<ColliderIndex> out);
 [[nodiscard]] Collider& GetColliderAt(ColliderIndex idx);
 void RemoveCollider(ColliderIndex idx);
+void RemoveColliders(std::span<const ColliderIndex> idxs);
+
+[[nodiscard]] DistanceConstraintIndex AddDistanceConstraint(const DistanceConstraintDesc& desc);
+void RemoveDistanceConstraint(DistanceConstraintIndex idx);
+
+[[nodiscard]] bool IsOverlapping(ColliderIndex idx);
+[[nodiscard]] int OverlapCount(ColliderIndex idx);
+[[nodiscard]] std::span<const ColliderIndex> GetOverlaps(ColliderIndex idx);
+
+[[nodiscard]] int QueryAABB(const Aabb& aabb, std::span<ColliderIndex> out,
+                            std::uint32_t categories = kAllCategories);
+[[nodiscard]] int QueryCircle(core::Vec2F center, float radius, std::span<ColliderIndex> out,
+                              std::uint32_t categories = kAllCategories);
+[[nodiscard]] int QueryPoint(core::Vec2F point, std::span<ColliderIndex> out,
+                             std::uint32_t categories = kAllCategories);
+bool Raycast(const Ray& ray, RayCastHit& hit, std::uint32_t categories = kAllCategories);
+[[nodiscard]] int KNearest(core::Vec2F point, std::span<ColliderIndex> out,
+                           std::uint32_t categories = kAllCategories);
+void QueryAABBs(std::span<const Aabb> boxes, std::span<ColliderIndex> out,
+                std::span<int> counts, std::uint32_t categories = kAllCategories);
+void Raycasts(std::span<const Ray> rays, std::span<RayCastHit> hits,
+              std::uint32_t categories = kAllCategories);
 
 void SetContactListener(ContactListener* l);
+void SetContactFilter(ContactFilter* f);
+void SetStayEvents(bool enabled);
+void SetContinuousCollision(bool enabled);
+[[nodiscard]] ContactEvents GetContactEvents();
+void DrainContactEvents(ContactEventBuffer& out);
+void Subscribe(ColliderIndex collider, ContactListener* listener);
+void SubscribeCategories(std::uint32_t categories, ContactListener* listener);
+void Unsubscribe(ContactListener* listener);
+
+void SetBroadPhase(BroadPhaseType type);
+[[nodiscard]] BroadPhaseType GetBroadPhase();
 
 } // namespace common::world
 
@@ -0,0 +1,51 @@
+﻿#ifndef COMMON_XPBD_SOLVER_H
+#define COMMON_XPBD_SOLVER_H
+
+#include <span>
+
+#include "contact_solver.h"
+#include "maths/vec2.h"
+
+namespace common::world {
+
+// Extended position based dynamics: each substep predicts the positions
+// from the velocities, projects every constraint once on the positions,
+// then takes the velocities back from the position change. Many cheap
+// substeps converge on dense piles where impulse iterations struggle.
+
+// Body columns read and written by a substep, indexed by slot. A zero
+// inverse mass is never written: static, kinematic, asleep or dead.
+struct XpbdBodies {
+  core::Vec2F*       position = nullptr;
+  core::Vec2F*       velocity = nullptr;
+  core::Vec2F*       previous = nullptr; // position at the substep start
+  const core::Vec2F* force = nullptr;
+  const float*       inverse_mass = nullptr;
+};
+
+// Two body slots kept length apart, compliance is the inverse stiffness
+// (0: rigid)
+struct DistanceConstraint {
+  int   a = 0;
+  int   b = 0;
+  float length = 0.f;
+  float compliance = 0.f;
+};
+
+// Bodies [first, last): v += F * w * h, then x += v * h
+void PredictPositions(const XpbdBodies& bodies, int first, int last, float h);
+
+// Bodies [first, last): v = (x - previous) / h
+void UpdateVelocities(const XpbdBodies& bodies, int first, int last, float h);
+
+// Non-penetration: only pushes circles closer than their radius of
+// contact apart
+void ProjectContacts(const XpbdBodies& bodies, std::span<const Contact> contacts,
+                     float compliance, float h);
+
+void ProjectDistances(const XpbdBodies& bodies,
+                      std::span<const DistanceConstraint> constraints, float h);
+
+} // namespace common::world
+
+#endif // COMMON_XPBD_SOLVER_H
@@ -1,33 +1,24 @@
 ﻿#include "body.h"
-#include "world.h"
 
 namespace common {
 
-Body::Body(const float mass_init) : mass(mass_init) {}
+Body::Body(core::Vec2F& position, core::Vec2F& velocity, core::Vec2F& force,
+           float& mass, float& inverse_mass, const BodyType& type,
+           const std::uint8_t& flags)
+    : position(position), velocity_(velocity), accumulated_force_(force),
+      mass_(mass), inverse_mass_(inverse_mass), type_(type), flags_(flags) {}
 
 void Body::Velocity(const core::Vec2F& vel) {
   velocity_ = vel;
 }
 
 void Body::AddForce(const core::Vec2F& force) {
-  accumulated_force += force; // on cumule les forces
+  accumulated_force_ += force; // on cumule les forces
 }
 
-void Body::Tick(const float dt) {
-  // Accélération a = F/m
-  core::Vec2F acceleration = accumulated_force / mass;
-
-  // Mise à jour de la vitesse
-  velocity_ += acceleration * dt;
-
-  // // Frottement de l'air
-  // velocity += -velocity * common::world::air_friction * dt;
-
-  // Mise à jour de la position
-  position += velocity_ * dt;
-
-  // Réinitialiser les forces pour la prochaine frame
-  accumulated_force = {0,0};
+void Body::SetMass(const float mass) {
+  mass_ = mass;
+  inverse_mass_ = InverseMass(mass, type_);
 }
 
 } // namespace common
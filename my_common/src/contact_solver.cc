@@ -0,0 +1,238 @@
+﻿#include "contact_solver.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "simd.h"
+
+#if COMMON_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace common::world {
+namespace {
+static_assert(sizeof(core::Vec2F) == 2 * sizeof(float),
+              "velocities are gathered as packed floats");
+
+void ApplyImpulse(const ContactBodies& bodies, const int a, const int b,
+                  const core::Vec2F p) {
+  const float inverse_a = bodies.inverse_mass[a];
+  const float inverse_b = bodies.inverse_mass[b];
+  if (inverse_a > 0.f) bodies.velocity[a] -= p * inverse_a;
+  if (inverse_b > 0.f) bodies.velocity[b] += p * inverse_b;
+}
+
+void SolveScalar(const ContactBodies& bodies, const ContactSoa& c, const int first,
+                 const int last) {
+  auto* v = reinterpret_cast<float*>(bodies.velocity);
+  for (int k = first; k < last; ++k) {
+    const int   xa = 2 * c.a[k];
+    const int   xb = 2 * c.b[k];
+    const float wa = bodies.inverse_mass[c.a[k]];
+    const float wb = bodies.inverse_mass[c.b[k]];
+    const float nx = c.normal_x[k];
+    const float ny = c.normal_y[k];
+    const float dvx = v[xb] - v[xa];
+    const float dvy = v[xb + 1] - v[xa + 1];
+    const float vnx = dvx * nx;
+    const float vny = dvy * ny;
+    const float vn = vnx + vny;
+    const float target = c.bounce[k] - vn;
+    const float step = c.normal_mass[k] * target;
+    // clamp the total, not the increment: a contact can only push
+    float total = c.impulse[k] + step;
+    total = total > 0.f ? total : 0.f;
+    const float d = total - c.impulse[k];
+    c.impulse[k] = total;
+    const float px = nx * d;
+    const float py = ny * d;
+    if (wa > 0.f) {
+      const float ax = px * wa;
+      const float ay = py * wa;
+      v[xa] -= ax;
+      v[xa + 1] -= ay;
+    }
+    if (wb > 0.f) {
+      const float bx = px * wb;
+      const float by = py * wb;
+      v[xb] += bx;
+      v[xb + 1] += by;
+    }
+  }
+}
+
+#if COMMON_SIMD_X86
+// Returns the first contact left to the scalar tail. max_ps gives 0 for
+// -0 and NaN like the scalar clamp.
+COMMON_TARGET_AVX2 int SolveAvx2(const ContactBodies& bodies, const ContactSoa& c,
+                                 const int first, const int last) {
+  auto*        v = reinterpret_cast<float*>(bodies.velocity);
+  const __m256 zero = _mm256_setzero_ps();
+  alignas(32) float new_v[4][8];
+  alignas(32) int   xa_lanes[8];
+  alignas(32) int   xb_lanes[8];
+  int k = first;
+  for (; k + 8 <= last; k += 8) {
+    const __m256i ia = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c.a + k));
+    const __m256i ib = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c.b + k));
+    const __m256i xa = _mm256_slli_epi32(ia, 1);
+    const __m256i xb = _mm256_slli_epi32(ib, 1);
+    const __m256  vax = _mm256_i32gather_ps(v, xa, 4);
+    const __m256  vay = _mm256_i32gather_ps(v + 1, xa, 4);
+    const __m256  vbx = _mm256_i32gather_ps(v, xb, 4);
+    const __m256  vby = _mm256_i32gather_ps(v + 1, xb, 4);
+    const __m256  wa = _mm256_i32gather_ps(bodies.inverse_mass, ia, 4);
+    const __m256  wb = _mm256_i32gather_ps(bodies.inverse_mass, ib, 4);
+    const __m256  nx = _mm256_loadu_ps(c.normal_x + k);
+    const __m256  ny = _mm256_loadu_ps(c.normal_y + k);
+    const __m256  impulse = _mm256_loadu_ps(c.impulse + k);
+
+    const __m256 vn = _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(vbx, vax), nx),
+                                    _mm256_mul_ps(_mm256_sub_ps(vby, vay), ny));
+    const __m256 step = _mm256_mul_ps(_mm256_loadu_ps(c.normal_mass + k),
+                                      _mm256_sub_ps(_mm256_loadu_ps(c.bounce + k), vn));
+    const __m256 total = _mm256_max_ps(_mm256_add_ps(impulse, step), zero);
+    const __m256 d = _mm256_sub_ps(total, impulse);
+    _mm256_storeu_ps(c.impulse + k, total);
+    const __m256 px = _mm256_mul_ps(nx, d);
+    const __m256 py = _mm256_mul_ps(ny, d);
+    _mm256_store_ps(new_v[0], _mm256_sub_ps(vax, _mm256_mul_ps(px, wa)));
+    _mm256_store_ps(new_v[1], _mm256_sub_ps(vay, _mm256_mul_ps(py, wa)));
+    _mm256_store_ps(new_v[2], _mm256_add_ps(vbx, _mm256_mul_ps(px, wb)));
+    _mm256_store_ps(new_v[3], _mm256_add_ps(vby, _mm256_mul_ps(py, wb)));
+
+    // no scatter in AVX2. Static bodies may be shared by several lanes
+    // and are never written.
+    _mm256_store_si256(reinterpret_cast<__m256i*>(xa_lanes), xa);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(xb_lanes), xb);
+    const int dynamic_a = _mm256_movemask_ps(_mm256_cmp_ps(wa, zero, _CMP_GT_OQ));
+    const int dynamic_b = _mm256_movemask_ps(_mm256_cmp_ps(wb, zero, _CMP_GT_OQ));
+    for (int l = 0; l < 8; ++l) {
+      if (dynamic_a >> l & 1) {
+        v[xa_lanes[l]] = new_v[0][l];
+        v[xa_lanes[l] + 1] = new_v[1][l];
+      }
+      if (dynamic_b >> l & 1) {
+        v[xb_lanes[l]] = new_v[2][l];
+        v[xb_lanes[l] + 1] = new_v[3][l];
+      }
+    }
+  }
+  return k;
+}
+
+COMMON_TARGET_AVX512 int SolveAvx512(const ContactBodies& bodies, const ContactSoa& c,
+                                     const int first, const int last) {
+  auto*        v = reinterpret_cast<float*>(bodies.velocity);
+  const __m512 zero = _mm512_setzero_ps();
+  int k = first;
+  for (; k + 16 <= last; k += 16) {
+    const __m512i ia = _mm512_loadu_si512(c.a + k);
+    const __m512i ib = _mm512_loadu_si512(c.b + k);
+    const __m512i xa = _mm512_slli_epi32(ia, 1);
+    const __m512i xb = _mm512_slli_epi32(ib, 1);
+    const __m512  vax = _mm512_i32gather_ps(xa, v, 4);
+    const __m512  vay = _mm512_i32gather_ps(xa, v + 1, 4);
+    const __m512  vbx = _mm512_i32gather_ps(xb, v, 4);
+    const __m512  vby = _mm512_i32gather_ps(xb, v + 1, 4);
+    const __m512  wa = _mm512_i32gather_ps(ia, bodies.inverse_mass, 4);
+    const __m512  wb = _mm512_i32gather_ps(ib, bodies.inverse_mass, 4);
+    const __m512  nx = _mm512_loadu_ps(c.normal_x + k);
+    const __m512  ny = _mm512_loadu_ps(c.normal_y + k);
+    const __m512  impulse = _mm512_loadu_ps(c.impulse + k);
+
+    const __m512 vn = _mm512_add_ps(_mm512_mul_ps(_mm512_sub_ps(vbx, vax), nx),
+                                    _mm512_mul_ps(_mm512_sub_ps(vby, vay), ny));
+    const __m512 step = _mm512_mul_ps(_mm512_loadu_ps(c.normal_mass + k),
+                                      _mm512_sub_ps(_mm512_loadu_ps(c.bounce + k), vn));
+    const __m512 total = _mm512_max_ps(_mm512_add_ps(impulse, step), zero);
+    const __m512 d = _mm512_sub_ps(total, impulse);
+    _mm512_storeu_ps(c.impulse + k, total);
+    const __m512 px = _mm512_mul_ps(nx, d);
+    const __m512 py = _mm512_mul_ps(ny, d);
+
+    // dynamic bodies are unique within the batch, the masks keep the
+    // shared static ones out of the scatters
+    const __mmask16 dynamic_a = _mm512_cmp_ps_mask(wa, zero, _CMP_GT_OQ);
+    const __mmask16 dynamic_b = _mm512_cmp_ps_mask(wb, zero, _CMP_GT_OQ);
+    _mm512_mask_i32scatter_ps(v, dynamic_a, xa, _mm512_sub_ps(vax, _mm512_mul_ps(px, wa)), 4);
+    _mm512_mask_i32scatter_ps(v + 1, dynamic_a, xa, _mm512_sub_ps(vay, _mm512_mul_ps(py, wa)), 4);
+    _mm512_mask_i32scatter_ps(v, dynamic_b, xb, _mm512_add_ps(vbx, _mm512_mul_ps(px, wb)), 4);
+    _mm512_mask_i32scatter_ps(v + 1, dynamic_b, xb, _mm512_add_ps(vby, _mm512_mul_ps(py, wb)), 4);
+  }
+  return k;
+}
+#endif
+} // namespace
+
+bool CircleManifold(const core::Vec2F pa, const float ra, const core::Vec2F pb,
+                    const float rb, Contact& contact) {
+  const core::Vec2F d = pb - pa;
+  const float distance_sqr = d.magnitude_sqr();
+  const float radius = ra + rb;
+  if (distance_sqr > radius * radius) return false;
+  const float distance = std::sqrt(distance_sqr);
+  contact.normal = distance > 0.f ? d / distance : core::Vec2F{1.f, 0.f};
+  contact.radius = radius;
+  return true;
+}
+
+void PrepareContacts(const ContactBodies& bodies, const ContactSoa& c, const int first,
+                     const int last, const SolverSettings& settings) {
+  for (int k = first; k < last; ++k) {
+    c.normal_mass[k] = 1.f / (bodies.inverse_mass[c.a[k]] + bodies.inverse_mass[c.b[k]]);
+    const core::Vec2F dv = bodies.velocity[c.b[k]] - bodies.velocity[c.a[k]];
+    const float vn = dv.x * c.normal_x[k] + dv.y * c.normal_y[k];
+    c.bounce[k] = vn < -settings.restitution_threshold ? -settings.restitution * vn : 0.f;
+  }
+}
+
+void WarmStartContacts(const ContactBodies& bodies, const ContactSoa& c, const int first,
+                       const int last) {
+  for (int k = first; k < last; ++k) {
+    const core::Vec2F normal{c.normal_x[k], c.normal_y[k]};
+    ApplyImpulse(bodies, c.a[k], c.b[k], normal * c.impulse[k]);
+  }
+}
+
+void SolveContactVelocities(const ContactBodies& bodies, const ContactSoa& contacts,
+                            const int first, const int last) {
+  int done = first;
+#if COMMON_SIMD_X86
+  switch (simd::ActiveLevel()) {
+    case simd::Level::kAvx512:
+      done = SolveAvx512(bodies, contacts, first, last);
+      break;
+    case simd::Level::kAvx2:
+      done = SolveAvx2(bodies, contacts, first, last);
+      break;
+    case simd::Level::kScalar:
+      break;
+  }
+#endif
+  SolveScalar(bodies, contacts, done, last);
+}
+
+void SolveContactPositions(const ContactBodies& bodies, const ContactSoa& c,
+                           const int first, const int last,
+                           const SolverSettings& settings) {
+  // Penetration removed on the positions directly, no energy is added
+  for (int k = first; k < last; ++k) {
+    const int         a = c.a[k];
+    const int         b = c.b[k];
+    const core::Vec2F d = bodies.position[b] - bodies.position[a];
+    const float distance = std::sqrt(d.magnitude_sqr());
+    const float penetration = c.radius[k] - distance - settings.slop;
+    if (penetration <= 0.f) continue;
+    const core::Vec2F normal =
+        distance > 0.f ? d / distance : core::Vec2F{c.normal_x[k], c.normal_y[k]};
+    const core::Vec2F p =
+        normal * (settings.position_correction * penetration * c.normal_mass[k]);
+    const float inverse_a = bodies.inverse_mass[a];
+    const float inverse_b = bodies.inverse_mass[b];
+    if (inverse_a > 0.f) bodies.position[a] -= p * inverse_a;
+    if (inverse_b > 0.f) bodies.position[b] += p * inverse_b;
+  }
+}
+
+} // namespace common::world
@@ -0,0 +1,358 @@
+﻿#include "dynamic_aabb_tree.h"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace common::world {
+namespace {
+Aabb Combine(const Aabb& a, const Aabb& b) {
+  return {{std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y)},
+          {std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y)}};
+}
+
+// 2D equivalent of the surface area heuristic
+float Perimeter(const Aabb& a) {
+  return 2.f * ((a.max.x - a.min.x) + (a.max.y - a.min.y));
+}
+
+core::Vec2F Center(const Aabb& a) {
+  return (a.min + a.max) * 0.5f;
+}
+} // namespace
+
+std::uint64_t DynamicAabbTree::PairKey(const int a, const int b) {
+  const auto lo = static_cast<std::uint32_t>(std::min(a, b));
+  const auto hi = static_cast<std::uint32_t>(std::max(a, b));
+  return static_cast<std::uint64_t>(lo) << 32 | hi;
+}
+
+float DynamicAabbTree::Margin(const Aabb& aabb) {
+  const float size = std::max(aabb.max.x - aabb.min.x, aabb.max.y - aabb.min.y);
+  return std::max(size * kMarginRatio, kMinMargin);
+}
+
+Aabb DynamicAabbTree::Fatten(const Aabb& aabb, const core::Vec2F& displacement) {
+  const float r = Margin(aabb);
+  Aabb fat{{aabb.min.x - r, aabb.min.y - r}, {aabb.max.x + r, aabb.max.y + r}};
+  // Predict where the body is heading
+  const core::Vec2F d = displacement * kDisplacementMultiplier;
+  if (d.x < 0.f) fat.min.x += d.x; else fat.max.x += d.x;
+  if (d.y < 0.f) fat.min.y += d.y; else fat.max.y += d.y;
+  return fat;
+}
+
+void DynamicAabbTree::Insert(const int proxy, const Aabb& aabb) {
+  if (proxy >= static_cast<int>(proxies_.size())) {
+    proxies_.resize(static_cast<std::size_t>(proxy) + 1);
+  }
+  if (proxies_[proxy].leaf != kNullNode) Remove(proxy);
+
+  const int leaf = AllocateNode();
+  nodes_[leaf].aabb = Fatten(aabb, {0, 0});
+  nodes_[leaf].height = 0;
+  nodes_[leaf].proxy = proxy;
+  InsertLeaf(leaf);
+
+  auto& p = proxies_[proxy];
+  p.aabb = aabb;
+  p.leaf = leaf;
+  if (!p.moved) {
+    p.moved = true;
+    move_buffer_.push_back(proxy);
+  }
+}
+
+void DynamicAabbTree::Remove(const int proxy) {
+  if (proxy < 0 || proxy >= static_cast<int>(proxies_.size())) return;
+  auto& p = proxies_[proxy];
+  if (p.leaf == kNullNode) return;
+  RemoveLeaf(p.leaf);
+  FreeNode(p.leaf);
+  p.leaf = kNullNode;
+  // Its pairs and move buffer entry are dropped by the next FindPairs
+}
+
+void DynamicAabbTree::Move(const int proxy, const Aabb& aabb) {
+  auto&             p = proxies_[proxy];
+  const core::Vec2F displacement = Center(aabb) - Center(p.aabb);
+  p.aabb = aabb;
+
+  const Aabb& fat = nodes_[p.leaf].aabb;
+  if (fat.Contains(aabb)) {
+    // Still inside, unless the fat box became far too big (body stopped)
+    Aabb huge = Fatten(aabb, displacement);
+    const float r = 4.f * Margin(aabb);
+    huge.min -= {r, r};
+    huge.max += {r, r};
+    if (huge.Contains(fat)) return;
+  }
+
+  RemoveLeaf(p.leaf);
+  nodes_[p.leaf].aabb = Fatten(aabb, displacement);
+  InsertLeaf(p.leaf);
+  if (!p.moved) {
+    p.moved = true;
+    move_buffer_.push_back(proxy);
+  }
+}
+
+void DynamicAabbTree::Query(const Aabb& aabb, QueryCallback& callback) const {
+  Query(aabb, [&callback](const int proxy) { return callback.Report(proxy); });
+}
+
+void DynamicAabbTree::FindPairs(std::vector<ProxyPair>& pairs) {
+  // Pairs whose fat boxes stopped overlapping, or whose proxy died
+  std::erase_if(pairs_, [this](const std::uint64_t key) {
+    const int a = proxies_[static_cast<int>(key >> 32)].leaf;
+    const int b = proxies_[static_cast<int>(key & 0xFFFFFFFFu)].leaf;
+    return a == kNullNode || b == kNullNode ||
+           !nodes_[a].aabb.Overlaps(nodes_[b].aabb);
+  });
+
+  // Only the reinserted leaves can have new neighbours
+  for (const int proxy : move_buffer_) {
+    const int leaf = proxies_[proxy].leaf;
+    if (leaf == kNullNode) continue;
+    const Aabb query = nodes_[leaf].aabb;
+
+    stack_.clear();
+    if (root_ != kNullNode) stack_.push_back(root_);
+    while (!stack_.empty()) {
+      const int node = stack_.back();
+      stack_.pop_back();
+      const Node& n = nodes_[node];
+      if (!n.aabb.Overlaps(query)) continue;
+      if (!n.IsLeaf()) {
+        stack_.push_back(n.child1);
+        stack_.push_back(n.child2);
+        continue;
+      }
+      if (node == leaf) continue;
+      // Two moved proxies see each other, keep only one of the queries
+      if (proxies_[n.proxy].moved && n.proxy < proxy) continue;
+      pairs_.insert(PairKey(proxy, n.proxy));
+    }
+  }
+  for (const int proxy : move_buffer_) proxies_[proxy].moved = false;
+  move_buffer_.clear();
+
+  pairs.reserve(pairs.size() + pairs_.size());
+  for (const auto key : pairs_) {
+    pairs.push_back({static_cast<int>(key >> 32),
+                     static_cast<int>(key & 0xFFFFFFFFu)});
+  }
+}
+
+int DynamicAabbTree::AllocateNode() {
+  if (free_list_ == kNullNode) {
+    nodes_.emplace_back();
+    return static_cast<int>(nodes_.size()) - 1;
+  }
+  const int node = free_list_;
+  free_list_ = nodes_[node].parent;
+  nodes_[node] = Node{};
+  return node;
+}
+
+void DynamicAabbTree::FreeNode(const int node) {
+  nodes_[node] = Node{};
+  nodes_[node].parent = free_list_;
+  free_list_ = node;
+}
+
+void DynamicAabbTree::InsertLeaf(const int leaf) {
+  if (root_ == kNullNode) {
+    root_ = leaf;
+    nodes_[root_].parent = kNullNode;
+    return;
+  }
+
+  // Find the best sibling, descending while it is cheaper than stopping
+  const Aabb leaf_aabb = nodes_[leaf].aabb;
+  int        index = root_;
+  while (!nodes_[index].IsLeaf()) {
+    const int child1 = nodes_[index].child1;
+    const int child2 = nodes_[index].child2;
+
+    const float area = Perimeter(nodes_[index].aabb);
+    const float combined_area = Perimeter(Combine(nodes_[index].aabb, leaf_aabb));
+
+    // Cost of making a new parent for this node and the new leaf
+    const float cost = 2.f * combined_area;
+    // Minimum cost of pushing the leaf further down the tree
+    const float inheritance_cost = 2.f * (combined_area - area);
+
+    const auto descend_cost = [&](const int child) {
+      const Aabb  aabb = Combine(leaf_aabb, nodes_[child].aabb);
+      const float new_area = Perimeter(aabb);
+      if (nodes_[child].IsLeaf()) return new_area + inheritance_cost;
+      return new_area - Perimeter(nodes_[child].aabb) + inheritance_cost;
+    };
+    const float cost1 = descend_cost(child1);
+    const float cost2 = descend_cost(child2);
+
+    if (cost < cost1 && cost < cost2) break;
+    index = cost1 < cost2 ? child1 : child2;
+  }
+  const int sibling = index;
+
+  // Create a new parent
+  const int old_parent = nodes_[sibling].parent;
+  const int new_parent = AllocateNode();
+  nodes_[new_parent].parent = old_parent;
+  nodes_[new_parent].aabb = Combine(leaf_aabb, nodes_[sibling].aabb);
+  nodes_[new_parent].height = nodes_[sibling].height + 1;
+  nodes_[new_parent].child1 = sibling;
+  nodes_[new_parent].child2 = leaf;
+  nodes_[sibling].parent = new_parent;
+  nodes_[leaf].parent = new_parent;
+
+  if (old_parent != kNullNode) {
+    if (nodes_[old_parent].child1 == sibling) {
+      nodes_[old_parent].child1 = new_parent;
+    } else {
+      nodes_[old_parent].child2 = new_parent;
+    }
+  } else {
+    root_ = new_parent;
+  }
+
+  // Walk back up fixing heights and boxes
+  index = nodes_[leaf].parent;
+  while (index != kNullNode) {
+    index = Balance(index);
+    const int child1 = nodes_[index].child1;
+    const int child2 = nodes_[index].child2;
+    nodes_[index].height = 1 + std::max(nodes_[child1].height, nodes_[child2].height);
+    nodes_[index].aabb = Combine(nodes_[child1].aabb, nodes_[child2].aabb);
+    index = nodes_[index].parent;
+  }
+}
+
+void DynamicAabbTree::RemoveLeaf(const int leaf) {
+  if (leaf == root_) {
+    root_ = kNullNode;
+    return;
+  }
+
+  const int parent = nodes_[leaf].parent;
+  const int grand_parent = nodes_[parent].parent;
+  const int sibling = nodes_[parent].child1 == leaf ? nodes_[parent].child2
+                                                    : nodes_[parent].child1;
+  if (grand_parent == kNullNode) {
+    root_ = sibling;
+    nodes_[sibling].parent = kNullNode;
+    FreeNode(parent);
+    return;
+  }
+
+  // Destroy the parent and connect the sibling to the grand parent
+  if (nodes_[grand_parent].child1 == parent) {
+    nodes_[grand_parent].child1 = sibling;
+  } else {
+    nodes_[grand_parent].child2 = sibling;
+  }
+  nodes_[sibling].parent = grand_parent;
+  FreeNode(parent);
+
+  int index = grand_parent;
+  while (index != kNullNode) {
+    index = Balance(index);
+    const int child1 = nodes_[index].child1;
+    const int child2 = nodes_[index].child2;
+    nodes_[index].aabb = Combine(nodes_[child1].aabb, nodes_[child2].aabb);
+    nodes_[index].height = 1 + std::max(nodes_[child1].height, nodes_[child2].height);
+    index = nodes_[index].parent;
+  }
+}
+
+// Rotates the higher child up when the subtree rooted at a is unbalanced,
+// returns the new subtree root.
+int DynamicAabbTree::Balance(const int a) {
+  Node& A = nodes_[a];
+  if (A.IsLeaf() || A.height < 2) return a;
+
+  const int b = A.child1;
+  const int c = A.child2;
+  Node&     B = nodes_[b];
+  Node&     C = nodes_[c];
+  const int balance = C.height - B.height;
+
+  const auto replace_in_parent = [this, a](const int parent, const int child) {
+    if (parent == kNullNode) {
+      root_ = child;
+    } else if (nodes_[parent].child1 == a) {
+      nodes_[parent].child1 = child;
+    } else {
+      nodes_[parent].child2 = child;
+    }
+  };
+
+  // Rotate C up
+  if (balance > 1) {
+    const int f = C.child1;
+    const int g = C.child2;
+    Node&     F = nodes_[f];
+    Node&     G = nodes_[g];
+
+    C.child1 = a;
+    C.parent = A.parent;
+    A.parent = c;
+    replace_in_parent(C.parent, c);
+
+    if (F.height > G.height) {
+      C.child2 = f;
+      A.child2 = g;
+      G.parent = a;
+      A.aabb = Combine(B.aabb, G.aabb);
+      C.aabb = Combine(A.aabb, F.aabb);
+      A.height = 1 + std::max(B.height, G.height);
+      C.height = 1 + std::max(A.height, F.height);
+    } else {
+      C.child2 = g;
+      A.child2 = f;
+      F.parent = a;
+      A.aabb = Combine(B.aabb, F.aabb);
+      C.aabb = Combine(A.aabb, G.aabb);
+      A.height = 1 + std::max(B.height, F.height);
+      C.height = 1 + std::max(A.height, G.height);
+    }
+    return c;
+  }
+
+  // Rotate B up
+  if (balance < -1) {
+    const int d = B.child1;
+    const int e = B.child2;
+    Node&     D = nodes_[d];
+    Node&     E = nodes_[e];
+
+    B.child1 = a;
+    B.parent = A.parent;
+    A.parent = b;
+    replace_in_parent(B.parent, b);
+
+    if (D.height > E.height) {
+      B.child2 = d;
+      A.child1 = e;
+      E.parent = a;
+      A.aabb = Combine(C.aabb, E.aabb);
+      B.aabb = Combine(A.aabb, D.aabb);
+      A.height = 1 + std::max(C.height, E.height);
+      B.height = 1 + std::max(A.height, D.height);
+    } else {
+      B.child2 = e;
+      A.child1 = d;
+      D.parent = a;
+      A.aabb = Combine(C.aabb, D.aabb);
+      B.aabb = Combine(A.aabb, E.aabb);
+      A.height = 1 + std::max(C.height, D.height);
+      B.height = 1 + std::max(A.height, E.height);
+    }
+    return b;
+  }
+
+  return a;
+}
+
+} // namespace common::world
@@ -0,0 +1,315 @@
+﻿#include "hierarchical_grid.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+
+#include "radix_sort.h"
+
+namespace common::world {
+namespace {
+core::Vec2F Center(const Aabb& a) {
+  return (a.min + a.max) * 0.5f;
+}
+
+float Size(const Aabb& a) {
+  return std::max(a.max.x - a.min.x, a.max.y - a.min.y);
+}
+
+// Spreads the 16 low bits of x on the even bits
+std::uint32_t SpreadBits(std::uint32_t x) {
+  x &= 0x0000FFFFu;
+  x = (x | (x << 8)) & 0x00FF00FFu;
+  x = (x | (x << 4)) & 0x0F0F0F0Fu;
+  x = (x | (x << 2)) & 0x33333333u;
+  x = (x | (x << 1)) & 0x55555555u;
+  return x;
+}
+
+constexpr int kMortonBits = 16; // per axis, past that the order is left as is
+
+// Same level neighbours on one side only: every pair of cells is seen once
+constexpr int kHalfNeighbours[4][2] = {{1, -1}, {1, 0}, {1, 1}, {0, 1}};
+} // namespace
+
+void HierarchicalGrid::Insert(const int proxy, const Aabb& aabb) {
+  if (proxy >= static_cast<int>(proxies_.size())) {
+    proxies_.resize(static_cast<std::size_t>(proxy) + 1);
+  }
+  auto& p = proxies_[proxy];
+  if (!p.alive) ++live_count_;
+  const bool pending = p.pending;
+  p = Proxy{aabb, base_cell_size_ > 0.f ? LevelFor(aabb) : -1, true, false, true};
+  if (!pending) unbuilt_.push_back(proxy);
+}
+
+void HierarchicalGrid::Remove(const int proxy) {
+  if (proxy < 0 || proxy >= static_cast<int>(proxies_.size())) return;
+  auto& p = proxies_[proxy];
+  if (!p.alive) return;
+  p.alive = false;
+  p.built = false;
+  --live_count_;
+}
+
+void HierarchicalGrid::Move(const int proxy, const Aabb& aabb) {
+  auto& p = proxies_[proxy];
+  p.aabb = aabb;
+  if (base_cell_size_ > 0.f) p.level = LevelFor(aabb);
+}
+
+void HierarchicalGrid::FindPairs(std::vector<ProxyPair>& pairs) {
+  if (NeedsResize()) Resize();
+  Build();
+
+  const auto test = [&](const int i, const int j) {
+    if (!member_boxes_[i].Overlaps(member_boxes_[j])) return;
+    const int a = members_[i];
+    const int b = members_[j];
+    pairs.push_back(a < b ? ProxyPair{a, b} : ProxyPair{b, a});
+  };
+  const auto test_cells = [&](const Cell& c, const Cell& other) {
+    for (int i = c.begin; i < c.end; ++i) {
+      for (int j = other.begin; j < other.end; ++j) test(i, j);
+    }
+  };
+
+  // 3x3 parents of the last cell, per coarse level. The cells come in
+  // Morton order, the cells sharing a parent follow each other
+  struct Parents {
+    int x = 0;
+    int y = 0;
+    int count = -1; // -1 = none yet
+    int cells[9];
+  };
+  Parents parents[kMaxLevels];
+
+  for (const Cell& c : cells_) {
+    for (int i = c.begin; i < c.end; ++i) {
+      for (int j = i + 1; j < c.end; ++j) test(i, j);
+    }
+    for (const auto& [dx, dy] : kHalfNeighbours) {
+      if (const int n = FindCell(c.level, c.x + dx, c.y + dy); n >= 0) {
+        test_cells(c, cells_[n]);
+      }
+    }
+    // Coarser occupied levels: a pair is always found from the finer of
+    // its two proxies, and every proxy of the cell has the same parents
+    std::uint64_t coarser = occupied_levels_ & ~((std::uint64_t{2} << c.level) - 1);
+    for (; coarser != 0; coarser &= coarser - 1) {
+      const int level = std::countr_zero(coarser);
+      const int shift = level - c.level;
+      Parents&  p = parents[level];
+      if (p.count < 0 || p.x != c.x >> shift || p.y != c.y >> shift) {
+        p.x = c.x >> shift;
+        p.y = c.y >> shift;
+        p.count = 0;
+        for (int x = p.x - 1; x <= p.x + 1; ++x) {
+          for (int y = p.y - 1; y <= p.y + 1; ++y) {
+            if (const int n = FindCell(level, x, y); n >= 0) p.cells[p.count++] = n;
+          }
+        }
+      }
+      for (int k = 0; k < p.count; ++k) test_cells(c, cells_[p.cells[k]]);
+    }
+  }
+}
+
+void HierarchicalGrid::Query(const Aabb& aabb, QueryCallback& callback) const {
+  const auto report = [&](const int m) {
+    return !proxies_[m].aabb.Overlaps(aabb) || callback.Report(m);
+  };
+  if (base_cell_size_ <= 0.f || slots_.empty()) {
+    for (int i = 0; i < static_cast<int>(proxies_.size()); ++i) {
+      if (proxies_[i].alive && !report(i)) return;
+    }
+    return;
+  }
+  const auto report_cell = [&](const Cell& c) {
+    for (int i = c.begin; i < c.end; ++i) {
+      const int m = members_[i];
+      // removed, or inserted again, since the table was built
+      if (proxies_[m].built && !report(m)) return false;
+    }
+    return true;
+  };
+  for (std::uint64_t levels = occupied_levels_; levels != 0; levels &= levels - 1) {
+    const int level = std::countr_zero(levels);
+    // A box fits its cell: its center is at most half a cell outside
+    const float half = 0.5f * std::ldexp(base_cell_size_, level);
+    const int   x0 = BaseCell(aabb.min.x - half) >> level;
+    const int   y0 = BaseCell(aabb.min.y - half) >> level;
+    const int   x1 = BaseCell(aabb.max.x + half) >> level;
+    const int   y1 = BaseCell(aabb.max.y + half) >> level;
+    const auto  cell_count = (static_cast<std::int64_t>(x1) - x0 + 1) *
+                            (static_cast<std::int64_t>(y1) - y0 + 1);
+    if (cell_count > level_cell_counts_[level]) {
+      for (const Cell& c : cells_) {
+        if (c.level == level && !report_cell(c)) return;
+      }
+      continue;
+    }
+    for (int x = x0; x <= x1; ++x) {
+      for (int y = y0; y <= y1; ++y) {
+        if (const int n = FindCell(level, x, y); n >= 0 && !report_cell(cells_[n])) return;
+      }
+    }
+  }
+  for (const int m : unbuilt_) {
+    const auto& p = proxies_[m];
+    if (p.alive && !p.built && !report(m)) return;
+  }
+}
+
+bool HierarchicalGrid::NeedsResize() const {
+  if (live_count_ == 0) return false;
+  return base_cell_size_ <= 0.f || live_count_ > 2 * sized_count_ ||
+         2 * live_count_ < sized_count_;
+}
+
+int HierarchicalGrid::LevelFor(const Aabb& aabb) const {
+  const float size = Size(aabb);
+  if (!(size > base_cell_size_)) return 0;
+  int level = static_cast<int>(std::ceil(std::log2(size / base_cell_size_)));
+  level = std::clamp(level, 0, kMaxLevels - 1);
+  // log2 may round down, the cell must hold the whole box
+  while (level < kMaxLevels - 1 && std::ldexp(base_cell_size_, level) < size) {
+    ++level;
+  }
+  return level;
+}
+
+std::size_t HierarchicalGrid::SlotFor(const int level, const std::uint64_t key) const {
+  const std::uint64_t h =
+      (key + static_cast<std::uint64_t>(level) * 0x632BE59BD9B4E019ull) *
+      0x9E3779B97F4A7C15ull;
+  return static_cast<std::size_t>(h >> slot_shift_);
+}
+
+int HierarchicalGrid::FindCell(const int level, const int x, const int y) const {
+  const std::uint64_t key = grid::CellKey(x, y);
+  for (std::size_t s = SlotFor(level, key);; s = (s + 1) & (slots_.size() - 1)) {
+    const Slot& slot = slots_[s];
+    if (slot.cell < 0) return -1;
+    if (slot.key == key && slot.level == level) return slot.cell;
+  }
+}
+
+int HierarchicalGrid::FindOrAddCell(const int level, const int x, const int y) {
+  const std::uint64_t key = grid::CellKey(x, y);
+  for (std::size_t s = SlotFor(level, key);; s = (s + 1) & (slots_.size() - 1)) {
+    Slot& slot = slots_[s];
+    if (slot.cell >= 0) {
+      if (slot.key == key && slot.level == level) return slot.cell;
+      continue;
+    }
+    slot = {key, level, static_cast<int>(cells_.size())};
+    cells_.push_back({x, y, level, 0, 0});
+    ++level_cell_counts_[level];
+    occupied_levels_ |= std::uint64_t{1} << level;
+    return slot.cell;
+  }
+}
+
+void HierarchicalGrid::Build() {
+  // At most one cell per proxy, the table stays under half full
+  const std::size_t capacity =
+      std::bit_ceil(std::max<std::size_t>(2 * static_cast<std::size_t>(live_count_), 16));
+  slots_.assign(capacity, Slot{});
+  slot_shift_ = 64 - std::countr_zero(capacity);
+  cells_.clear();
+  occupied_levels_ = 0;
+  std::fill(std::begin(level_cell_counts_), std::end(level_cell_counts_), 0);
+  for (const int proxy : unbuilt_) proxies_[proxy].pending = false;
+  unbuilt_.clear();
+  if (base_cell_size_ <= 0.f) return;
+
+  // Base cells of the centers, ordered along a Morton curve: the cells are
+  // then created in Morton order on every level
+  const int n = static_cast<int>(proxies_.size());
+  base_x_.resize(proxies_.size());
+  base_y_.resize(proxies_.size());
+  keys_.clear();
+  constexpr int kMaxCell = static_cast<int>(grid::kMaxCellCoord);
+  int min_x = kMaxCell;
+  int min_y = kMaxCell;
+  int max_x = -kMaxCell;
+  int max_y = -kMaxCell;
+  for (int i = 0; i < n; ++i) {
+    auto& p = proxies_[i];
+    p.built = p.alive;
+    if (!p.alive) continue;
+    const core::Vec2F center = Center(p.aabb);
+    base_x_[i] = BaseCell(center.x);
+    base_y_[i] = BaseCell(center.y);
+    min_x = std::min(min_x, base_x_[i]);
+    min_y = std::min(min_y, base_y_[i]);
+    max_x = std::max(max_x, base_x_[i]);
+    max_y = std::max(max_y, base_y_[i]);
+    keys_.push_back(static_cast<std::uint32_t>(i));
+  }
+  const auto span = static_cast<std::uint32_t>(
+      std::max<std::int64_t>(std::int64_t{max_x} - min_x, std::int64_t{max_y} - min_y));
+  if (!keys_.empty() && std::bit_width(span) <= kMortonBits) {
+    for (auto& key : keys_) {
+      const auto i = static_cast<std::size_t>(key);
+      const std::uint32_t code =
+          SpreadBits(static_cast<std::uint32_t>(base_x_[i] - min_x)) |
+          SpreadBits(static_cast<std::uint32_t>(base_y_[i] - min_y)) << 1;
+      key |= static_cast<std::uint64_t>(code) << 32;
+    }
+    RadixSort(keys_, sort_scratch_, 32, 32 + 2 * std::bit_width(span));
+  }
+
+  // Counting sort of the proxies by cell
+  proxy_cells_.resize(proxies_.size());
+  for (const auto key : keys_) {
+    const auto i = static_cast<int>(key & 0xFFFFFFFFu);
+    const int  level = proxies_[i].level;
+    const int  cell = FindOrAddCell(level, base_x_[i] >> level, base_y_[i] >> level);
+    proxy_cells_[i] = cell;
+    ++cells_[cell].end;
+  }
+  int offset = 0;
+  for (Cell& c : cells_) {
+    c.begin = offset;
+    offset += c.end;
+    c.end = c.begin;
+  }
+  members_.resize(static_cast<std::size_t>(offset));
+  member_boxes_.resize(static_cast<std::size_t>(offset));
+  for (const auto key : keys_) {
+    const auto i = static_cast<int>(key & 0xFFFFFFFFu);
+    const int  m = cells_[proxy_cells_[i]].end++;
+    members_[m] = i;
+    member_boxes_[m] = proxies_[i].aabb;
+  }
+}
+
+void HierarchicalGrid::Resize() {
+  std::vector<float> sizes;
+  sizes.reserve(static_cast<std::size_t>(live_count_));
+  for (const auto& p : proxies_) {
+    if (!p.alive) continue;
+    const float size = Size(p.aabb);
+    if (std::isfinite(size)) sizes.push_back(size);
+  }
+  float base = 1.f;
+  if (!sizes.empty()) {
+    const auto quantile = sizes.begin() + static_cast<std::ptrdiff_t>(
+                              static_cast<float>(sizes.size() - 1) * kSizeQuantile);
+    std::ranges::nth_element(sizes, quantile);
+    // a hair above: boxes of that very size must not round up a level
+    base = *quantile * 1.001f;
+  }
+  // Un cercle de rayon nul ne doit pas donner une grille infiniment fine
+  base_cell_size_ = std::max(base, 1e-3f);
+  inv_base_cell_size_ = 1.f / base_cell_size_;
+  sized_count_ = live_count_;
+  for (auto& p : proxies_) {
+    if (p.alive) p.level = LevelFor(p.aabb);
+  }
+}
+
+} // namespace common::world
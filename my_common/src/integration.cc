@@ -0,0 +1,118 @@
+﻿#include "integration.h"
+
+#include <algorithm>
+
+#include "simd.h"
+
+#if COMMON_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace common::world {
+namespace {
+void IntegrateScalar(const BodySoa& b, const std::size_t first,
+                     const std::size_t last, const float dt) {
+  for (std::size_t i = first; i < last; ++i) {
+    const float inverse_mass = b.inverse_mass[i];
+    for (std::size_t k = 2 * i; k < 2 * i + 2; ++k) {
+      const float a = b.force[k] * inverse_mass;
+      const float dv = a * dt;
+      b.velocity[k] += dv;
+      const float dp = b.velocity[k] * dt;
+      b.position[k] += dp;
+      b.force[k] = 0.f;
+    }
+  }
+}
+
+#if COMMON_SIMD_X86
+// Returns the first body left to the scalar tail
+COMMON_TARGET_AVX2 std::size_t IntegrateAvx2(const BodySoa& b,
+                                             const std::size_t first,
+                                             const std::size_t last,
+                                             const float dt) {
+  // inverse masses m0 m1 m2 m3 spread to the x and y lanes of each body
+  const __m256i spread = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+  const __m256  vdt = _mm256_set1_ps(dt);
+  std::size_t   i = first;
+  for (; i + 4 <= last; i += 4) {
+    const __m256 inverse_mass = _mm256_permutevar8x32_ps(
+        _mm256_castps128_ps256(_mm_loadu_ps(b.inverse_mass + i)), spread);
+    float* const f = b.force + 2 * i;
+    float* const v = b.velocity + 2 * i;
+    float* const p = b.position + 2 * i;
+    const __m256 a = _mm256_mul_ps(_mm256_loadu_ps(f), inverse_mass);
+    const __m256 vel = _mm256_add_ps(_mm256_loadu_ps(v), _mm256_mul_ps(a, vdt));
+    _mm256_storeu_ps(v, vel);
+    _mm256_storeu_ps(p, _mm256_add_ps(_mm256_loadu_ps(p), _mm256_mul_ps(vel, vdt)));
+    _mm256_storeu_ps(f, _mm256_setzero_ps());
+  }
+  return i;
+}
+
+COMMON_TARGET_AVX512 std::size_t IntegrateAvx512(const BodySoa& b,
+                                                 const std::size_t first,
+                                                 const std::size_t last,
+                                                 const float dt) {
+  const __m512i spread = _mm512_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5,
+                                           6, 6, 7, 7);
+  const __m512 vdt = _mm512_set1_ps(dt);
+  std::size_t  i = first;
+  for (; i + 8 <= last; i += 8) {
+    const __m512 inverse_mass = _mm512_permutexvar_ps(
+        spread, _mm512_castps256_ps512(_mm256_loadu_ps(b.inverse_mass + i)));
+    float* const f = b.force + 2 * i;
+    float* const v = b.velocity + 2 * i;
+    float* const p = b.position + 2 * i;
+    const __m512 a = _mm512_mul_ps(_mm512_loadu_ps(f), inverse_mass);
+    const __m512 vel = _mm512_add_ps(_mm512_loadu_ps(v), _mm512_mul_ps(a, vdt));
+    _mm512_storeu_ps(v, vel);
+    _mm512_storeu_ps(p, _mm512_add_ps(_mm512_loadu_ps(p), _mm512_mul_ps(vel, vdt)));
+    _mm512_storeu_ps(f, _mm512_setzero_ps());
+  }
+  return i;
+}
+#endif
+} // namespace
+
+void IntegrateRange(const BodySoa& bodies, const std::size_t first,
+                    const std::size_t last, const float dt) {
+  std::size_t done = first;
+#if COMMON_SIMD_X86
+  switch (simd::ActiveLevel()) {
+    case simd::Level::kAvx512:
+      done = IntegrateAvx512(bodies, first, last, dt);
+      break;
+    case simd::Level::kAvx2:
+      done = IntegrateAvx2(bodies, first, last, dt);
+      break;
+    case simd::Level::kScalar:
+      break;
+  }
+#endif
+  IntegrateScalar(bodies, done, last, dt);
+}
+
+void Integrate(const BodySoa& bodies, const std::size_t count, const float dt,
+               ThreadPool& pool) {
+  pool.ParallelFor(static_cast<int>(count), kIntegrationGrain,
+                   [&](const int begin, const int end, int) {
+                     IntegrateRange(bodies, static_cast<std::size_t>(begin),
+                                    static_cast<std::size_t>(end), dt);
+                   });
+}
+
+void IntegrateSpans(const BodySoa& bodies, const std::span<const BodySpan> spans,
+                    const float dt, ThreadPool& pool) {
+  const int count = static_cast<int>(spans.size());
+  // a few chunks per thread, spans may be anything from 1 to a grain long
+  const int grain = std::max(1, count / (4 * pool.thread_count()));
+  pool.ParallelFor(count, grain, [&](const int begin, const int end, int) {
+    for (int s = begin; s < end; ++s) {
+      IntegrateRange(bodies, static_cast<std::size_t>(spans[s].begin),
+                     static_cast<std::size_t>(spans[s].end), dt);
+    }
+  });
+}
+
+} // namespace common::world
@@ -0,0 +1,241 @@
+﻿#include "linear_bvh.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <limits>
+
+#include "radix_sort.h"
+
+namespace common::world {
+namespace {
+constexpr int   kMortonBits = 15; // per axis, 30-bit codes
+constexpr float kMortonMax = (1 << kMortonBits) - 1;
+constexpr int   kGrain = 1024;
+constexpr int   kTraversalGrain = 256;
+
+// Spreads the 15 low bits of x on the even bits
+std::uint32_t SpreadBits(std::uint32_t x) {
+  x &= 0x00007FFFu;
+  x = (x | (x << 8)) & 0x00FF00FFu;
+  x = (x | (x << 4)) & 0x0F0F0F0Fu;
+  x = (x | (x << 2)) & 0x33333333u;
+  x = (x | (x << 1)) & 0x55555555u;
+  return x;
+}
+
+std::uint32_t Quantize(const float v, const float min, const float scale) {
+  const float t = (v - min) * scale;
+  if (!(t > 0.f)) return 0; // NaN aussi
+  return static_cast<std::uint32_t>(std::min(t, kMortonMax));
+}
+
+Aabb Combine(const Aabb& a, const Aabb& b) {
+  return {{std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y)},
+          {std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y)}};
+}
+} // namespace
+
+void LinearBvh::Insert(const int proxy, const Aabb& aabb) {
+  if (proxy >= static_cast<int>(proxies_.size())) {
+    proxies_.resize(static_cast<std::size_t>(proxy) + 1);
+  }
+  auto&      p = proxies_[proxy];
+  const bool pending = p.pending;
+  p = {aabb, true, false, true};
+  if (!pending) unbuilt_.push_back(proxy);
+}
+
+void LinearBvh::Remove(const int proxy) {
+  if (proxy < 0 || proxy >= static_cast<int>(proxies_.size())) return;
+  proxies_[proxy].alive = false;
+  proxies_[proxy].built = false;
+}
+
+void LinearBvh::Move(const int proxy, const Aabb& aabb) {
+  proxies_[proxy].aabb = aabb;
+}
+
+void LinearBvh::FindPairs(std::vector<ProxyPair>& pairs) {
+  Build();
+  const int n = static_cast<int>(live_.size());
+  if (n < 2) return;
+
+  // Each leaf only looks at the leaves after it in Morton order, so every
+  // pair is found once and the threads never share a node
+  thread_pairs_.resize(static_cast<std::size_t>(pool_->thread_count()));
+  for (auto& out : thread_pairs_) out.clear();
+  pool_->ParallelFor(n, kTraversalGrain, [this, n](const int begin,
+                                                   const int end,
+                                                   const int thread) {
+    auto& out = thread_pairs_[static_cast<std::size_t>(thread)];
+    std::vector<int> stack;
+    stack.reserve(64);
+    for (int k = begin; k < end; ++k) {
+      const Node& leaf = nodes_[static_cast<std::size_t>(n - 1 + k)];
+      stack.clear();
+      stack.push_back(0);
+      while (!stack.empty()) {
+        const Node& node = nodes_[static_cast<std::size_t>(stack.back())];
+        stack.pop_back();
+        if (node.last <= k || !node.aabb.Overlaps(leaf.aabb)) continue;
+        if (node.left < 0) {
+          out.push_back(leaf.proxy < node.proxy
+                            ? ProxyPair{leaf.proxy, node.proxy}
+                            : ProxyPair{node.proxy, leaf.proxy});
+          continue;
+        }
+        stack.push_back(node.left);
+        stack.push_back(node.right);
+      }
+    }
+  });
+
+  for (const auto& out : thread_pairs_) {
+    pairs.insert(pairs.end(), out.begin(), out.end());
+  }
+}
+
+void LinearBvh::Query(const Aabb& aabb, QueryCallback& callback) const {
+  // Tree of the last FindPairs. A leaf whose proxy was removed, or
+  // inserted again, since is skipped: the proxies inserted since are
+  // tested one by one
+  const auto query_unbuilt = [&] {
+    for (const int proxy : unbuilt_) {
+      const auto& p = proxies_[proxy];
+      if (p.alive && !p.built && p.aabb.Overlaps(aabb) && !callback.Report(proxy)) return;
+    }
+  };
+  const int n = static_cast<int>(live_.size());
+  if (n < 2) {
+    for (const int proxy : live_) {
+      const auto& p = proxies_[proxy];
+      if (p.built && p.aabb.Overlaps(aabb) && !callback.Report(proxy)) return;
+    }
+    return query_unbuilt();
+  }
+  // depth <= 64, the keys are 64 bits
+  std::array<int, 2 * 64 + 2> stack;
+  int size = 0;
+  stack[size++] = 0;
+  while (size > 0) {
+    const Node& node = nodes_[static_cast<std::size_t>(stack[--size])];
+    if (!node.aabb.Overlaps(aabb)) continue;
+    if (node.left < 0) {
+      if (proxies_[node.proxy].built && !callback.Report(node.proxy)) return;
+      continue;
+    }
+    stack[size++] = node.left;
+    stack[size++] = node.right;
+  }
+  query_unbuilt();
+}
+
+void LinearBvh::Build() {
+  for (const int proxy : unbuilt_) proxies_[proxy].pending = false;
+  unbuilt_.clear();
+  live_.clear();
+  Aabb bounds{{std::numeric_limits<float>::max(), std::numeric_limits<float>::max()},
+              {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()}};
+  for (int i = 0; i < static_cast<int>(proxies_.size()); ++i) {
+    proxies_[i].built = proxies_[i].alive;
+    if (!proxies_[i].alive) continue;
+    live_.push_back(i);
+    const Aabb& aabb = proxies_[i].aabb;
+    const core::Vec2F center = (aabb.min + aabb.max) * 0.5f;
+    bounds.min = {std::min(bounds.min.x, center.x), std::min(bounds.min.y, center.y)};
+    bounds.max = {std::max(bounds.max.x, center.x), std::max(bounds.max.y, center.y)};
+  }
+  const int n = static_cast<int>(live_.size());
+  if (n < 2) return;
+
+  // Morton codes of the box centers
+  const float extent_x = bounds.max.x - bounds.min.x;
+  const float extent_y = bounds.max.y - bounds.min.y;
+  const float scale_x = extent_x > 0.f ? kMortonMax / extent_x : 0.f;
+  const float scale_y = extent_y > 0.f ? kMortonMax / extent_y : 0.f;
+  keys_.resize(static_cast<std::size_t>(n));
+  pool_->ParallelFor(n, kGrain, [&](const int begin, const int end, int) {
+    for (int i = begin; i < end; ++i) {
+      const Aabb& aabb = proxies_[live_[i]].aabb;
+      const core::Vec2F center = (aabb.min + aabb.max) * 0.5f;
+      const std::uint32_t code =
+          SpreadBits(Quantize(center.x, bounds.min.x, scale_x)) |
+          SpreadBits(Quantize(center.y, bounds.min.y, scale_y)) << 1;
+      keys_[i] = static_cast<std::uint64_t>(code) << 32 |
+                 static_cast<std::uint32_t>(i);
+    }
+  });
+  RadixSort(keys_, scratch_, 32, 32 + 2 * kMortonBits, pool_);
+
+  nodes_.assign(static_cast<std::size_t>(2 * n - 1), Node{});
+  pool_->ParallelFor(n, kGrain, [&](const int begin, const int end, int) {
+    for (int k = begin; k < end; ++k) {
+      Node& leaf = nodes_[static_cast<std::size_t>(n - 1 + k)];
+      leaf.proxy = live_[keys_[k] & 0xFFFFFFFFu];
+      leaf.aabb = proxies_[leaf.proxy].aabb;
+      leaf.last = k;
+    }
+  });
+
+  // Length of the common prefix of two keys, -1 out of range
+  const auto delta = [this, n](const int i, const int j) {
+    if (j < 0 || j >= n) return -1;
+    return std::countl_zero(keys_[i] ^ keys_[j]);
+  };
+  pool_->ParallelFor(n - 1, kGrain, [&](const int begin, const int end, int) {
+    for (int i = begin; i < end; ++i) {
+      // Direction of the range covered by node i
+      const int d = delta(i, i + 1) - delta(i, i - 1) > 0 ? 1 : -1;
+      const int delta_min = delta(i, i - d);
+
+      // Upper bound then binary search of the other end
+      int l_max = 2;
+      while (delta(i, i + l_max * d) > delta_min) l_max *= 2;
+      int l = 0;
+      for (int t = l_max / 2; t >= 1; t /= 2) {
+        if (delta(i, i + (l + t) * d) > delta_min) l += t;
+      }
+      const int j = i + l * d;
+
+      // Split position, where the common prefix changes
+      const int delta_node = delta(i, j);
+      int s = 0;
+      int t = l;
+      do {
+        t = (t + 1) / 2;
+        if (delta(i, i + (s + t) * d) > delta_node) s += t;
+      } while (t > 1);
+      const int gamma = i + s * d + std::min(d, 0);
+
+      const int first = std::min(i, j);
+      const int last = std::max(i, j);
+      Node& node = nodes_[static_cast<std::size_t>(i)];
+      node.left = first == gamma ? n - 1 + gamma : gamma;
+      node.right = last == gamma + 1 ? n - 1 + gamma + 1 : gamma + 1;
+      node.last = last;
+      nodes_[static_cast<std::size_t>(node.left)].parent = i;
+      nodes_[static_cast<std::size_t>(node.right)].parent = i;
+    }
+  });
+
+  // Bottom-up refit, the second child to arrive computes the parent box
+  visits_.assign(static_cast<std::size_t>(n - 1), 0);
+  pool_->ParallelFor(n, kGrain, [&](const int begin, const int end, int) {
+    for (int k = begin; k < end; ++k) {
+      int node = nodes_[static_cast<std::size_t>(n - 1 + k)].parent;
+      while (node >= 0) {
+        std::atomic_ref visits(visits_[static_cast<std::size_t>(node)]);
+        if (visits.fetch_add(1, std::memory_order_acq_rel) == 0) break;
+        Node& parent = nodes_[static_cast<std::size_t>(node)];
+        parent.aabb = Combine(nodes_[static_cast<std::size_t>(parent.left)].aabb,
+                              nodes_[static_cast<std::size_t>(parent.right)].aabb);
+        node = parent.parent;
+      }
+    }
+  });
+}
+
+} // namespace common::world
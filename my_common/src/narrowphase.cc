@@ -0,0 +1,214 @@
+﻿#include "narrowphase.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "simd.h"
+
+#if COMMON_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace common::world {
+namespace {
+static_assert(sizeof(ProxyPair) == 2 * sizeof(int),
+              "pairs are loaded as interleaved ints");
+
+void SetBit(std::uint64_t* mask, const std::size_t k) {
+  mask[k >> 6] |= std::uint64_t{1} << (k & 63);
+}
+
+bool Overlap(const CircleSoa& c, const int a, const int b) {
+  const float r = c.radius[a] + c.radius[b];
+  const float dx = c.x[a] - c.x[b];
+  const float dy = c.y[a] - c.y[b];
+  // Same rounding as the SIMD paths as long as mul + add isn't fused:
+  // -ffp-contract=off in my_common/CMakeLists.txt
+  const float dx2 = dx * dx;
+  const float dy2 = dy * dy;
+  const float dist2 = dx2 + dy2;
+  const float r2 = r * r;
+  return dist2 <= r2;
+}
+
+void PairsScalar(const CircleSoa& c, const ProxyPair* pairs,
+                 const std::size_t begin, const std::size_t count,
+                 std::uint64_t* mask) {
+  for (std::size_t k = begin; k < count; ++k) {
+    if (Overlap(c, pairs[k].a, pairs[k].b)) SetBit(mask, k);
+  }
+}
+
+void RowScalar(const CircleSoa& c, const int i, const int first,
+               const std::size_t begin, const std::size_t count,
+               std::uint64_t* mask) {
+  for (std::size_t k = begin; k < count; ++k) {
+    if (Overlap(c, i, first + static_cast<int>(k))) SetBit(mask, k);
+  }
+}
+
+#if COMMON_SIMD_X86
+// Groups of 8 or 16 never straddle two 64-bit words
+COMMON_TARGET_AVX2 std::size_t PairsAvx2(const CircleSoa& c,
+                                         const ProxyPair* pairs,
+                                         const std::size_t count,
+                                         std::uint64_t* mask) {
+  const auto*   ids = reinterpret_cast<const int*>(pairs);
+  const __m256i deinterleave = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+  std::size_t   k = 0;
+  for (; k + 8 <= count; k += 8) {
+    // [a0 a1 a2 a3 b0 b1 b2 b3] and [a4 .. a7 b4 .. b7]
+    const __m256i lo = _mm256_permutevar8x32_epi32(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ids + 2 * k)),
+        deinterleave);
+    const __m256i hi = _mm256_permutevar8x32_epi32(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ids + 2 * k + 8)),
+        deinterleave);
+    const __m256i a = _mm256_permute2x128_si256(lo, hi, 0x20);
+    const __m256i b = _mm256_permute2x128_si256(lo, hi, 0x31);
+
+    const __m256 r = _mm256_add_ps(_mm256_i32gather_ps(c.radius, a, 4),
+                                   _mm256_i32gather_ps(c.radius, b, 4));
+    const __m256 dx = _mm256_sub_ps(_mm256_i32gather_ps(c.x, a, 4),
+                                    _mm256_i32gather_ps(c.x, b, 4));
+    const __m256 dy = _mm256_sub_ps(_mm256_i32gather_ps(c.y, a, 4),
+                                    _mm256_i32gather_ps(c.y, b, 4));
+    const __m256 dist2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+    const __m256 hit = _mm256_cmp_ps(dist2, _mm256_mul_ps(r, r), _CMP_LE_OQ);
+    mask[k >> 6] |= static_cast<std::uint64_t>(_mm256_movemask_ps(hit)) << (k & 63);
+  }
+  return k;
+}
+
+COMMON_TARGET_AVX2 std::size_t RowAvx2(const CircleSoa& c, const int i,
+                                       const int first, const std::size_t count,
+                                       std::uint64_t* mask) {
+  const __m256 xi = _mm256_set1_ps(c.x[i]);
+  const __m256 yi = _mm256_set1_ps(c.y[i]);
+  const __m256 ri = _mm256_set1_ps(c.radius[i]);
+  std::size_t  k = 0;
+  for (; k + 8 <= count; k += 8) {
+    const std::size_t j = static_cast<std::size_t>(first) + k;
+    const __m256 r = _mm256_add_ps(ri, _mm256_loadu_ps(c.radius + j));
+    const __m256 dx = _mm256_sub_ps(xi, _mm256_loadu_ps(c.x + j));
+    const __m256 dy = _mm256_sub_ps(yi, _mm256_loadu_ps(c.y + j));
+    const __m256 dist2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+    const __m256 hit = _mm256_cmp_ps(dist2, _mm256_mul_ps(r, r), _CMP_LE_OQ);
+    mask[k >> 6] |= static_cast<std::uint64_t>(_mm256_movemask_ps(hit)) << (k & 63);
+  }
+  return k;
+}
+
+COMMON_TARGET_AVX512 std::size_t PairsAvx512(const CircleSoa& c,
+                                             const ProxyPair* pairs,
+                                             const std::size_t count,
+                                             std::uint64_t* mask) {
+  const auto*   ids = reinterpret_cast<const int*>(pairs);
+  const __m512i even = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20,
+                                         22, 24, 26, 28, 30);
+  const __m512i odd = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21,
+                                        23, 25, 27, 29, 31);
+  std::size_t k = 0;
+  for (; k + 16 <= count; k += 16) {
+    const __m512i lo = _mm512_loadu_si512(ids + 2 * k);
+    const __m512i hi = _mm512_loadu_si512(ids + 2 * k + 16);
+    const __m512i a = _mm512_permutex2var_epi32(lo, even, hi);
+    const __m512i b = _mm512_permutex2var_epi32(lo, odd, hi);
+
+    const __m512 r = _mm512_add_ps(_mm512_i32gather_ps(a, c.radius, 4),
+                                   _mm512_i32gather_ps(b, c.radius, 4));
+    const __m512 dx = _mm512_sub_ps(_mm512_i32gather_ps(a, c.x, 4),
+                                    _mm512_i32gather_ps(b, c.x, 4));
+    const __m512 dy = _mm512_sub_ps(_mm512_i32gather_ps(a, c.y, 4),
+                                    _mm512_i32gather_ps(b, c.y, 4));
+    const __m512 dist2 = _mm512_add_ps(_mm512_mul_ps(dx, dx), _mm512_mul_ps(dy, dy));
+    const __mmask16 hit = _mm512_cmp_ps_mask(dist2, _mm512_mul_ps(r, r), _CMP_LE_OQ);
+    mask[k >> 6] |= static_cast<std::uint64_t>(hit) << (k & 63);
+  }
+  return k;
+}
+
+COMMON_TARGET_AVX512 std::size_t RowAvx512(const CircleSoa& c, const int i,
+                                           const int first,
+                                           const std::size_t count,
+                                           std::uint64_t* mask) {
+  const __m512 xi = _mm512_set1_ps(c.x[i]);
+  const __m512 yi = _mm512_set1_ps(c.y[i]);
+  const __m512 ri = _mm512_set1_ps(c.radius[i]);
+  std::size_t  k = 0;
+  for (; k + 16 <= count; k += 16) {
+    const std::size_t j = static_cast<std::size_t>(first) + k;
+    const __m512 r = _mm512_add_ps(ri, _mm512_loadu_ps(c.radius + j));
+    const __m512 dx = _mm512_sub_ps(xi, _mm512_loadu_ps(c.x + j));
+    const __m512 dy = _mm512_sub_ps(yi, _mm512_loadu_ps(c.y + j));
+    const __m512 dist2 = _mm512_add_ps(_mm512_mul_ps(dx, dx), _mm512_mul_ps(dy, dy));
+    const __mmask16 hit = _mm512_cmp_ps_mask(dist2, _mm512_mul_ps(r, r), _CMP_LE_OQ);
+    mask[k >> 6] |= static_cast<std::uint64_t>(hit) << (k & 63);
+  }
+  return k;
+}
+#endif
+} // namespace
+
+void OverlapPairs(const CircleSoa& circles, const ProxyPair* pairs,
+                  const std::size_t count, std::uint64_t* mask) {
+  std::fill(mask, mask + MaskWordCount(count), std::uint64_t{0});
+  std::size_t done = 0;
+#if COMMON_SIMD_X86
+  switch (simd::ActiveLevel()) {
+    case simd::Level::kAvx512:
+      done = PairsAvx512(circles, pairs, count, mask);
+      break;
+    case simd::Level::kAvx2:
+      done = PairsAvx2(circles, pairs, count, mask);
+      break;
+    case simd::Level::kScalar:
+      break;
+  }
+#endif
+  PairsScalar(circles, pairs, done, count, mask);
+}
+
+void OverlapRow(const CircleSoa& circles, const int i, const int first,
+                const int last, std::uint64_t* mask) {
+  if (last <= first) return;
+  const auto count = static_cast<std::size_t>(last - first);
+  std::fill(mask, mask + MaskWordCount(count), std::uint64_t{0});
+  std::size_t done = 0;
+#if COMMON_SIMD_X86
+  switch (simd::ActiveLevel()) {
+    case simd::Level::kAvx512:
+      done = RowAvx512(circles, i, first, count, mask);
+      break;
+    case simd::Level::kAvx2:
+      done = RowAvx2(circles, i, first, count, mask);
+      break;
+    case simd::Level::kScalar:
+      break;
+  }
+#endif
+  RowScalar(circles, i, first, done, count, mask);
+}
+
+float TimeOfImpact(const CircleSoa& circles, const int a, const int b) {
+  // relative position s + t * m for t in [0, 1], m the relative motion
+  const float mx = circles.dx[a] - circles.dx[b];
+  const float my = circles.dy[a] - circles.dy[b];
+  const float sx = circles.x[a] - circles.x[b] - mx;
+  const float sy = circles.y[a] - circles.y[b] - my;
+  const float r = circles.radius[a] + circles.radius[b];
+  const float c = sx * sx + sy * sy - r * r;
+  if (c <= 0.f) return 0.f;
+  const float a2 = mx * mx + my * my;
+  const float b2 = sx * mx + sy * my;
+  constexpr float kNever = std::numeric_limits<float>::infinity();
+  // not moving, or moving apart
+  if (a2 == 0.f || b2 >= 0.f) return kNever;
+  const float discriminant = b2 * b2 - a2 * c;
+  if (discriminant < 0.f) return kNever;
+  const float t = (-b2 - std::sqrt(discriminant)) / a2;
+  return t <= 1.f ? t : kNever;
+}
+
+} // namespace common::world
@@ -0,0 +1,107 @@
+﻿#include "radix_sort.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+#include "thread_pool.h"
+
+namespace common {
+namespace {
+constexpr int kRadixBits = 8;
+constexpr int kBuckets = 1 << kRadixBits;
+// Below this many keys waking the workers costs more than it saves
+constexpr std::size_t kMinParallelKeys = std::size_t{1} << 14;
+
+using Histogram = std::array<std::size_t, kBuckets>;
+} // namespace
+
+void RadixSort(std::vector<std::uint64_t>& keys,
+               std::vector<std::uint64_t>& scratch, const int first_bit,
+               const int last_bit, ThreadPool* pool) {
+  const std::size_t n = keys.size();
+  if (n < 2 || first_bit >= last_bit) return;
+  if (scratch.size() < n) scratch.resize(n);
+
+  const int blocks = pool != nullptr && n >= kMinParallelKeys
+                         ? pool->thread_count()
+                         : 1;
+  const std::size_t block_size = (n + static_cast<std::size_t>(blocks) - 1) /
+                                 static_cast<std::size_t>(blocks);
+  // One histogram per block, kept around between calls
+  thread_local std::vector<Histogram> cached_histograms;
+  if (cached_histograms.size() < static_cast<std::size_t>(blocks)) {
+    cached_histograms.resize(static_cast<std::size_t>(blocks));
+  }
+  // The workers must see the caller's copy, not their own thread_local one
+  std::vector<Histogram>& histograms = cached_histograms;
+
+  std::uint64_t* src = keys.data();
+  std::uint64_t* dst = scratch.data();
+  int            shift = first_bit;
+  std::uint64_t  mask = 0;
+
+  const auto for_each_block = [&](const auto& fn) {
+    if (blocks == 1) {
+      fn(0, 1, 0);
+    } else {
+      pool->ParallelFor(blocks, 1, fn);
+    }
+  };
+  const auto count_block = [&](const int begin, const int end, int) {
+    for (int b = begin; b < end; ++b) {
+      Histogram& h = histograms[static_cast<std::size_t>(b)];
+      h.fill(0);
+      const std::size_t first = static_cast<std::size_t>(b) * block_size;
+      const std::size_t last = std::min(first + block_size, n);
+      for (std::size_t i = first; i < last; ++i) {
+        ++h[(src[i] >> shift) & mask];
+      }
+    }
+  };
+  const auto scatter_block = [&](const int begin, const int end, int) {
+    for (int b = begin; b < end; ++b) {
+      Histogram& h = histograms[static_cast<std::size_t>(b)];
+      const std::size_t first = static_cast<std::size_t>(b) * block_size;
+      const std::size_t last = std::min(first + block_size, n);
+      for (std::size_t i = first; i < last; ++i) {
+        dst[h[(src[i] >> shift) & mask]++] = src[i];
+      }
+    }
+  };
+
+  for (; shift < last_bit; shift += kRadixBits) {
+    const int bits = std::min(kRadixBits, last_bit - shift);
+    mask = (std::uint64_t{1} << bits) - 1;
+
+    for_each_block(count_block);
+
+    // Exclusive prefix sum, digit major then block, keeps the sort stable
+    std::size_t sum = 0;
+    bool        single_bucket = false;
+    for (int d = 0; d < kBuckets && !single_bucket; ++d) {
+      std::size_t digit_count = 0;
+      for (int b = 0; b < blocks; ++b) {
+        digit_count += histograms[static_cast<std::size_t>(b)][d];
+      }
+      single_bucket = digit_count == n;
+    }
+    // Every key has the same digit, nothing to move
+    if (single_bucket) continue;
+    for (int d = 0; d < kBuckets; ++d) {
+      for (int b = 0; b < blocks; ++b) {
+        std::size_t& offset = histograms[static_cast<std::size_t>(b)][d];
+        const std::size_t c = offset;
+        offset = sum;
+        sum += c;
+      }
+    }
+
+    for_each_block(scatter_block);
+    std::swap(src, dst);
+  }
+
+  if (src != keys.data()) std::copy(src, src + n, keys.data());
+}
+
+} // namespace common
@@ -0,0 +1,53 @@
+﻿#include "simd.h"
+
+#include <algorithm>
+#include <atomic>
+
+#if COMMON_SIMD_X86 && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace common::simd {
+namespace {
+std::atomic<Level> max_level{Level::kAvx512};
+
+Level Detect() {
+#if !COMMON_SIMD_X86
+  return Level::kScalar;
+#elif defined(_MSC_VER) && !defined(__clang__)
+  int info[4];
+  __cpuid(info, 1);
+  const bool os_xsave = (info[2] & (1 << 27)) != 0;
+  const bool avx = (info[2] & (1 << 28)) != 0;
+  if (!os_xsave || !avx) return Level::kScalar;
+  // The OS must save the ymm (and zmm) registers on context switch
+  const unsigned long long xcr0 = _xgetbv(0);
+  if ((xcr0 & 0x6) != 0x6) return Level::kScalar;
+  __cpuidex(info, 7, 0);
+  const bool avx2 = (info[1] & (1 << 5)) != 0;
+  const bool avx512f = (info[1] & (1 << 16)) != 0;
+  if (avx512f && (xcr0 & 0xE6) == 0xE6) return Level::kAvx512;
+  return avx2 ? Level::kAvx2 : Level::kScalar;
+#else
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) return Level::kAvx512;
+  if (__builtin_cpu_supports("avx2")) return Level::kAvx2;
+  return Level::kScalar;
+#endif
+}
+} // namespace
+
+Level DetectLevel() {
+  static const Level level = Detect();
+  return level;
+}
+
+Level ActiveLevel() {
+  return std::min(DetectLevel(), max_level.load(std::memory_order_relaxed));
+}
+
+void SetMaxLevel(const Level level) {
+  max_level.store(level, std::memory_order_relaxed);
+}
+
+} // namespace common::simd
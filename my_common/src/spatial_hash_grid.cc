@@ -0,0 +1,191 @@
+﻿#include "spatial_hash_grid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace common::world {
+using grid::CellKey;
+using grid::CellX;
+using grid::CellY;
+using grid::ToCell;
+
+void SpatialHashGrid::Insert(const int proxy, const Aabb& aabb) {
+  if (proxy >= static_cast<int>(proxies_.size())) {
+    proxies_.resize(static_cast<std::size_t>(proxy) + 1);
+  }
+  auto& p = proxies_[proxy];
+  if (p.alive) Unbin(proxy);
+  p = Proxy{aabb, {}, true, false};
+  ++live_count_;
+  if (cell_size_ > 0.f) Bin(proxy);
+}
+
+void SpatialHashGrid::Remove(const int proxy) {
+  if (proxy < 0 || proxy >= static_cast<int>(proxies_.size())) return;
+  auto& p = proxies_[proxy];
+  if (!p.alive) return;
+  Unbin(proxy);
+  p.alive = false;
+  --live_count_;
+}
+
+void SpatialHashGrid::Move(const int proxy, const Aabb& aabb) {
+  auto& p = proxies_[proxy];
+  p.aabb = aabb;
+  if (cell_size_ <= 0.f) return;
+  if (const CellRange range = ComputeRange(aabb); range == p.cells) return;
+  Unbin(proxy);
+  Bin(proxy);
+}
+
+void SpatialHashGrid::FindPairs(std::vector<ProxyPair>& pairs) {
+  if (NeedsResize()) Resize();
+
+  for (const auto& [key, members] : cells_) {
+    const int cx = CellX(key);
+    const int cy = CellY(key);
+    const auto count = members.size();
+    for (std::size_t i = 0; i < count; ++i) {
+      const int   a = members[i];
+      const auto& pa = proxies_[a];
+      for (std::size_t j = i + 1; j < count; ++j) {
+        const int   b = members[j];
+        const auto& pb = proxies_[b];
+        if (!pa.aabb.Overlaps(pb.aabb)) continue;
+        // Only the first shared cell reports the pair
+        if (std::max(pa.cells.x0, pb.cells.x0) != cx ||
+            std::max(pa.cells.y0, pb.cells.y0) != cy)
+          continue;
+        pairs.push_back(a < b ? ProxyPair{a, b} : ProxyPair{b, a});
+      }
+    }
+  }
+
+  // Oversized proxies are not binned, they are tested against everyone
+  for (const int l : large_proxies_) {
+    const auto& pl = proxies_[l];
+    for (int other = 0; other < static_cast<int>(proxies_.size()); ++other) {
+      const auto& po = proxies_[other];
+      if (other == l || !po.alive) continue;
+      if (po.large && other < l) continue; // large/large reported once
+      if (!pl.aabb.Overlaps(po.aabb)) continue;
+      pairs.push_back(l < other ? ProxyPair{l, other} : ProxyPair{other, l});
+    }
+  }
+}
+
+void SpatialHashGrid::Query(const Aabb& aabb, QueryCallback& callback) const {
+  const auto scan = [&] {
+    for (int i = 0; i < static_cast<int>(proxies_.size()); ++i) {
+      const auto& p = proxies_[i];
+      if (p.alive && p.aabb.Overlaps(aabb) && !callback.Report(i)) return;
+    }
+  };
+  if (cell_size_ <= 0.f) return scan();
+  const CellRange range = ComputeRange(aabb);
+  const auto cell_count = (static_cast<std::int64_t>(range.x1) - range.x0 + 1) *
+                          (static_cast<std::int64_t>(range.y1) - range.y0 + 1);
+  // more cells to look up than proxies to test
+  if (cell_count > live_count_) return scan();
+
+  for (int x = range.x0; x <= range.x1; ++x) {
+    for (int y = range.y0; y <= range.y1; ++y) {
+      const auto it = cells_.find(CellKey(x, y));
+      if (it == cells_.end()) continue;
+      for (const int m : it->second) {
+        const auto& p = proxies_[m];
+        if (!p.aabb.Overlaps(aabb)) continue;
+        // Only the first cell shared with the query reports it
+        if (std::max(p.cells.x0, range.x0) != x || std::max(p.cells.y0, range.y0) != y)
+          continue;
+        if (!callback.Report(m)) return;
+      }
+    }
+  }
+  for (const int l : large_proxies_) {
+    if (proxies_[l].aabb.Overlaps(aabb) && !callback.Report(l)) return;
+  }
+}
+
+bool SpatialHashGrid::NeedsResize() const {
+  if (live_count_ == 0) return false;
+  return cell_size_ <= 0.f || live_count_ > 2 * sized_count_ ||
+         2 * live_count_ < sized_count_;
+}
+
+SpatialHashGrid::CellRange SpatialHashGrid::ComputeRange(
+    const Aabb& aabb) const {
+  return {ToCell(aabb.min.x, inv_cell_size_), ToCell(aabb.min.y, inv_cell_size_),
+          ToCell(aabb.max.x, inv_cell_size_), ToCell(aabb.max.y, inv_cell_size_)};
+}
+
+void SpatialHashGrid::Bin(const int proxy) {
+  auto& p = proxies_[proxy];
+  p.cells = ComputeRange(p.aabb);
+  // int64 pour eviter le debordement sur les gros rayons
+  const auto cell_count =
+      (static_cast<std::int64_t>(p.cells.x1) - p.cells.x0 + 1) *
+      (static_cast<std::int64_t>(p.cells.y1) - p.cells.y0 + 1);
+  if (cell_count > kMaxCellsPerProxy) {
+    p.large = true;
+    large_proxies_.push_back(proxy);
+    return;
+  }
+  for (int x = p.cells.x0; x <= p.cells.x1; ++x) {
+    for (int y = p.cells.y0; y <= p.cells.y1; ++y) {
+      cells_[CellKey(x, y)].push_back(proxy);
+    }
+  }
+}
+
+void SpatialHashGrid::Unbin(const int proxy) {
+  auto& p = proxies_[proxy];
+  if (p.large) {
+    std::erase(large_proxies_, proxy);
+    p.large = false;
+  } else {
+    for (int x = p.cells.x0; x <= p.cells.x1; ++x) {
+      for (int y = p.cells.y0; y <= p.cells.y1; ++y) {
+        const auto it = cells_.find(CellKey(x, y));
+        if (it == cells_.end()) continue;
+        auto& members = it->second;
+        const auto m = std::ranges::find(members, proxy);
+        if (m == members.end()) continue;
+        *m = members.back();
+        members.pop_back();
+        if (members.empty()) cells_.erase(it);
+      }
+    }
+  }
+  p.cells = {};
+}
+
+void SpatialHashGrid::Resize() {
+  std::vector<float> sizes;
+  sizes.reserve(static_cast<std::size_t>(live_count_));
+  for (const auto& p : proxies_) {
+    if (!p.alive) continue;
+    const float size = std::max(p.aabb.max.x - p.aabb.min.x,
+                                p.aabb.max.y - p.aabb.min.y);
+    if (std::isfinite(size)) sizes.push_back(size);
+  }
+  if (sizes.empty()) return;
+  const auto quantile = sizes.begin() + static_cast<std::ptrdiff_t>(
+                            static_cast<float>(sizes.size() - 1) * kSizeQuantile);
+  std::ranges::nth_element(sizes, quantile);
+  // Un cercle de rayon nul ne doit pas donner une grille infiniment fine
+  cell_size_ = std::max(*quantile, 1e-3f);
+  inv_cell_size_ = 1.f / cell_size_;
+  sized_count_ = live_count_;
+
+  cells_.clear();
+  large_proxies_.clear();
+  for (int i = 0; i < static_cast<int>(proxies_.size()); ++i) {
+    proxies_[i].large = false;
+    proxies_[i].cells = {};
+    if (proxies_[i].alive) Bin(i);
+  }
+}
+
+} // namespace common::world
@@ -0,0 +1,155 @@
+﻿#include "sweep_and_prune.h"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace common::world {
+namespace {
+float Component(const core::Vec2F& v, const int axis) {
+  return axis == 0 ? v.x : v.y;
+}
+} // namespace
+
+std::uint64_t SweepAndPrune::PairKey(const int a, const int b) {
+  const auto lo = static_cast<std::uint32_t>(std::min(a, b));
+  const auto hi = static_cast<std::uint32_t>(std::max(a, b));
+  return static_cast<std::uint64_t>(lo) << 32 | hi;
+}
+
+void SweepAndPrune::Insert(const int proxy, const Aabb& aabb) {
+  if (proxy >= static_cast<int>(proxies_.size())) {
+    proxies_.resize(static_cast<std::size_t>(proxy) + 1);
+  }
+  // The slot is reused before the old endpoints were dropped
+  if (proxies_[proxy].in_axes) Purge();
+  if (proxies_[proxy].in_axes) return; // already live
+
+  proxies_[proxy] = Proxy{aabb, true, true};
+  const auto id = static_cast<std::uint32_t>(proxy) << 1;
+  for (auto& endpoints : axes_) {
+    // Appended at the end, the insertion sort moves them in place and
+    // reports their overlaps on the way
+    endpoints.push_back({0.f, id});
+    endpoints.push_back({0.f, id | 1u});
+  }
+  ++live_count_;
+  ++inserted_count_;
+}
+
+void SweepAndPrune::Remove(const int proxy) {
+  if (proxy < 0 || proxy >= static_cast<int>(proxies_.size())) return;
+  auto& p = proxies_[proxy];
+  if (!p.alive) return;
+  // Endpoints and pairs are dropped in one pass at the next FindPairs
+  p.alive = false;
+  has_removed_ = true;
+  --live_count_;
+}
+
+void SweepAndPrune::Move(const int proxy, const Aabb& aabb) {
+  proxies_[proxy].aabb = aabb;
+}
+
+void SweepAndPrune::FindPairs(std::vector<ProxyPair>& pairs) {
+  if (has_removed_) Purge();
+  Refresh();
+  // Adding a lot of boxes at once would make the insertion sort quadratic
+  if (4 * inserted_count_ > live_count_) {
+    Rebuild();
+  } else {
+    SortAxis(0);
+    SortAxis(1);
+  }
+  inserted_count_ = 0;
+
+  pairs.reserve(pairs.size() + pairs_.size());
+  for (const auto key : pairs_) {
+    pairs.push_back({static_cast<int>(key >> 32),
+                     static_cast<int>(key & 0xFFFFFFFFu)});
+  }
+}
+
+void SweepAndPrune::Query(const Aabb& aabb, QueryCallback& callback) const {
+  // The sorted axes index the pairs, not space: a query is a pass over
+  // the boxes
+  for (int i = 0; i < static_cast<int>(proxies_.size()); ++i) {
+    const auto& p = proxies_[i];
+    if (p.alive && p.aabb.Overlaps(aabb) && !callback.Report(i)) return;
+  }
+}
+
+void SweepAndPrune::Purge() {
+  for (auto& endpoints : axes_) {
+    std::erase_if(endpoints, [this](const Endpoint& e) {
+      return !proxies_[e.proxy()].alive;
+    });
+  }
+  std::erase_if(pairs_, [this](const std::uint64_t key) {
+    return !proxies_[static_cast<int>(key >> 32)].alive ||
+           !proxies_[static_cast<int>(key & 0xFFFFFFFFu)].alive;
+  });
+  for (auto& p : proxies_) {
+    if (!p.alive) p.in_axes = false;
+  }
+  has_removed_ = false;
+}
+
+void SweepAndPrune::Refresh() {
+  for (int axis = 0; axis < 2; ++axis) {
+    for (auto& e : axes_[axis]) {
+      const Aabb& aabb = proxies_[e.proxy()].aabb;
+      e.value = Component(e.is_max() ? aabb.max : aabb.min, axis);
+    }
+  }
+}
+
+void SweepAndPrune::SortAxis(const int axis) {
+  auto&             endpoints = axes_[axis];
+  const std::size_t count = endpoints.size();
+  for (std::size_t i = 1; i < count; ++i) {
+    const Endpoint key = endpoints[i];
+    std::size_t    j = i;
+    while (j > 0 && Less(key, endpoints[j - 1])) {
+      const Endpoint& other = endpoints[j - 1];
+      const int       a = key.proxy();
+      const int       b = other.proxy();
+      if (a != b) {
+        if (!key.is_max() && other.is_max()) {
+          // a starts before b ends on this axis, check the other one
+          if (proxies_[a].aabb.Overlaps(proxies_[b].aabb)) {
+            pairs_.insert(PairKey(a, b));
+          }
+        } else if (key.is_max() && !other.is_max()) {
+          // a now ends before b starts
+          pairs_.erase(PairKey(a, b));
+        }
+      }
+      endpoints[j] = other;
+      --j;
+    }
+    endpoints[j] = key;
+  }
+}
+
+void SweepAndPrune::Rebuild() {
+  for (auto& endpoints : axes_) {
+    std::ranges::sort(endpoints, Less);
+  }
+  pairs_.clear();
+  active_.clear();
+  for (const auto& e : axes_[0]) {
+    const int proxy = e.proxy();
+    if (e.is_max()) {
+      std::erase(active_, proxy);
+      continue;
+    }
+    for (const int other : active_) {
+      if (proxies_[proxy].aabb.Overlaps(proxies_[other].aabb)) {
+        pairs_.insert(PairKey(proxy, other));
+      }
+    }
+    active_.push_back(proxy);
+  }
+}
+
+} // namespace common::world
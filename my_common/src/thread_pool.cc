@@ -0,0 +1,106 @@
+﻿#include "thread_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace common {
+
+ThreadPool::ThreadPool(const int worker_count) {
+  workers_.reserve(static_cast<std::size_t>(std::max(worker_count, 0)));
+  for (int i = 0; i < worker_count; ++i) {
+    workers_.emplace_back([this, i] { WorkerLoop(i + 1); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::scoped_lock lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (auto& worker : workers_) worker.join();
+}
+
+int ThreadPool::DefaultWorkerCount() {
+  const int hardware = static_cast<int>(std::thread::hardware_concurrency());
+  return std::max(hardware - 1, 0);
+}
+
+void ThreadPool::ParallelFor(const int count, const int grain,
+                             const RangeFunction& fn) {
+  if (count <= 0) return;
+  const int chunk = std::max(grain, 1);
+
+  bool expected = false;
+  if (workers_.empty() || count <= chunk ||
+      !busy_.compare_exchange_strong(expected, true)) {
+    for (int begin = 0; begin < count; begin += chunk) {
+      fn(begin, std::min(begin + chunk, count), 0);
+    }
+    return;
+  }
+
+  {
+    std::scoped_lock lock(mutex_);
+    job_ = &fn;
+    count_ = count;
+    grain_ = chunk;
+    next_.store(0, std::memory_order_relaxed);
+    pending_ = static_cast<int>(workers_.size());
+    ++generation_;
+  }
+  wake_.notify_all();
+
+  RunChunks(0);
+
+  // the workers may still call fn: wait for them even if it threw
+  std::exception_ptr error;
+  {
+    std::unique_lock lock(mutex_);
+    done_.wait(lock, [this] { return pending_ == 0; });
+    job_ = nullptr;
+    error = std::exchange(error_, nullptr);
+  }
+  busy_.store(false);
+  if (error) std::rethrow_exception(error);
+}
+
+void ThreadPool::WorkerLoop(const int thread) {
+  std::uint64_t seen = 0;
+  for (;;) {
+    {
+      std::unique_lock lock(mutex_);
+      wake_.wait(lock, [this, seen] { return stop_ || generation_ != seen; });
+      if (stop_) return;
+      seen = generation_;
+    }
+    RunChunks(thread);
+    {
+      std::scoped_lock lock(mutex_);
+      if (--pending_ == 0) done_.notify_one();
+    }
+  }
+}
+
+void ThreadPool::RunChunks(const int thread) {
+  for (;;) {
+    const int begin = next_.fetch_add(grain_);
+    if (begin >= count_) return;
+    try {
+      (*job_)(begin, std::min(begin + grain_, count_), thread);
+    } catch (...) {
+      // the chunks left are skipped, the caller rethrows
+      next_.store(count_);
+      std::scoped_lock lock(mutex_);
+      if (!error_) error_ = std::current_exception();
+      return;
+    }
+  }
+}
+
+ThreadPool& GetThreadPool() {
+  static ThreadPool pool;
+  return pool;
+}
+
+} // namespace common
@@ -0,0 +1,112 @@
+﻿#include "work_stealing_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace common {
+namespace {
+// Pool and deque of the worker running on this thread
+thread_local const WorkStealingPool* current_pool = nullptr;
+thread_local int                     current_thread = -1;
+} // namespace
+
+WorkStealingPool::WorkStealingPool(const int thread_count) {
+  const int count = std::max(thread_count, 1);
+  queues_.reserve(static_cast<std::size_t>(count));
+  for (int i = 0; i < count; ++i) queues_.push_back(std::make_unique<Queue>());
+  workers_.reserve(static_cast<std::size_t>(count));
+  for (int i = 0; i < count; ++i) {
+    workers_.emplace_back([this, i] { WorkerLoop(i); });
+  }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::unique_lock lock(mutex_);
+    idle_.wait(lock, [this] { return pending_.load() == 0; });
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (auto& worker : workers_) worker.join();
+}
+
+int WorkStealingPool::DefaultThreadCount() {
+  return std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+}
+
+void WorkStealingPool::Submit(Task task) {
+  const int count = static_cast<int>(queues_.size());
+  const int thread = current_pool == this
+                         ? current_thread
+                         : static_cast<int>(next_queue_.fetch_add(1) % count);
+  pending_.fetch_add(1);
+  {
+    auto& queue = *queues_[thread];
+    std::scoped_lock lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+  }
+  {
+    // under the lock, a worker checking queued_ can't miss the wake up
+    std::scoped_lock lock(mutex_);
+    queued_.fetch_add(1);
+  }
+  wake_.notify_one();
+}
+
+void WorkStealingPool::Wait() {
+  std::unique_lock lock(mutex_);
+  idle_.wait(lock, [this] { return pending_.load() == 0; });
+  if (error_) std::rethrow_exception(std::exchange(error_, nullptr));
+}
+
+bool WorkStealingPool::TryPop(const int thread, Task& task) {
+  // own deque from the back: the task submitted last is the hottest
+  {
+    auto& queue = *queues_[thread];
+    std::scoped_lock lock(queue.mutex);
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+      return true;
+    }
+  }
+  // others from the front: the oldest tasks tend to be the largest
+  const int count = static_cast<int>(queues_.size());
+  for (int k = 1; k < count; ++k) {
+    auto& queue = *queues_[(thread + k) % count];
+    std::scoped_lock lock(queue.mutex);
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkStealingPool::WorkerLoop(const int thread) {
+  current_pool = this;
+  current_thread = thread;
+  for (;;) {
+    Task task;
+    if (!TryPop(thread, task)) {
+      std::unique_lock lock(mutex_);
+      wake_.wait(lock, [this] { return stop_ || queued_.load() > 0; });
+      if (stop_ && queued_.load() == 0) return;
+      continue;
+    }
+    queued_.fetch_sub(1);
+    try {
+      task();
+    } catch (...) {
+      std::scoped_lock lock(mutex_);
+      if (!error_) error_ = std::current_exception();
+    }
+    if (pending_.fetch_sub(1) == 1) {
+      std::scoped_lock lock(mutex_);
+      idle_.notify_all();
+    }
+  }
+}
+
+} // namespace common
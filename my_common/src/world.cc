@@ -1,147 +1,1688 @@
 ﻿#include "world.h"
-#include <ranges>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <numeric>
 #include <stdexcept>
+#include <string>
 #include <vector>
-#include <optional>
+
+#include "dynamic_aabb_tree.h"
+#include "hierarchical_grid.h"
+#include "integration.h"
+#include "linear_bvh.h"
+#include "narrowphase.h"
+#include "radix_sort.h"
+#include "spatial_hash_grid.h"
+#include "sweep_and_prune.h"
 
 namespace common::world {
 namespace {
-  // bodies are already stored as pairs (Body, generation)
-  std::vector<std::pair<Body, int>> bodies;
+  // a < b, sorting the keys sorts the pairs by (a, b)
+  std::uint64_t PairKey(const int a, const int b) {
+    return static_cast<std::uint64_t>(static_cast<std::uint32_t>(a)) << 32 |
+           static_cast<std::uint32_t>(b);
+  }
+
+  // calls fn(k) for every bit set in the mask, in increasing order
+  template <typename Fn>
+  void ForEachSetBit(const std::vector<std::uint64_t>& mask, Fn&& fn) {
+    for (std::size_t w = 0; w < mask.size(); ++w) {
+      for (std::uint64_t bits = mask[w]; bits != 0; bits &= bits - 1) {
+        fn(w * 64 + static_cast<std::size_t>(std::countr_zero(bits)));
+      }
+    }
+  }
+
+  static_assert(sizeof(core::Vec2F) == 2 * sizeof(float),
+                "body columns are integrated as packed floats");
+
+  float* Floats(std::vector<core::Vec2F>& column) {
+    return reinterpret_cast<float*>(column.data());
+  }
+
+  // union-find with path halving
+  int FindRoot(std::vector<int>& parent, int i) {
+    while (parent[i] != i) {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+    return i;
+  }
+
+  bool IsZero(const core::Vec2F& v) {
+    return v.x == 0.f && v.y == 0.f;
+  }
+
+  // null for kBruteForce
+  std::unique_ptr<BroadPhase> MakeBroadPhase(const BroadPhaseType type,
+                                             ThreadPool* pool) {
+    switch (type) {
+      case BroadPhaseType::kBruteForce:
+        return nullptr;
+      case BroadPhaseType::kSpatialHash:
+        return std::make_unique<SpatialHashGrid>();
+      case BroadPhaseType::kSweepAndPrune:
+        return std::make_unique<SweepAndPrune>();
+      case BroadPhaseType::kDynamicTree:
+        return std::make_unique<DynamicAabbTree>();
+      case BroadPhaseType::kLinearBvh:
+        return std::make_unique<LinearBvh>(pool);
+      case BroadPhaseType::kHierarchicalGrid:
+        return std::make_unique<HierarchicalGrid>();
+    }
+    return nullptr;
+  }
+}
+
+World::World(ThreadPool& pool)
+    : pool_(&pool), static_tree_(std::make_unique<DynamicAabbTree>()) {}
+
+World::~World() = default;
+
+// ---------- Body functions ----------
+int World::BodySlot(const BodyIndex body_index, const char* what) const {
+  // slot of a live handle, throws like the rest of the API otherwise
+  if (body_index.index() < 0 ||
+      body_index.index() >= static_cast<int>(body_generations_.size())) {
+    throw std::out_of_range(std::string("Trying to ") + what +
+                            " a body with an out of range index");
+  }
+  if (body_index.generationIndex() != body_generations_[body_index.index()]) {
+    throw std::runtime_error(std::string("Trying to ") + what +
+                             " a body with an invalid generation index");
+  }
+  return body_index.index();
+}
+
+std::size_t World::GrowBodies(const std::size_t count) {
+  // Appends count slots to every body column, returns the first
+  const std::size_t first = body_masses_.size();
+  const std::size_t size = first + count;
+  body_positions_.resize(size);
+  body_velocities_.resize(size);
+  body_forces_.resize(size);
+  body_inverse_masses_.resize(size);
+  body_masses_.resize(size);
+  body_generations_.resize(size, 0);
+  body_types_.resize(size, BodyType::kDynamic);
+  body_flags_.resize(size, 0);
+  body_quiet_ticks_.resize(size, 0);
+  body_next_free_.resize(size, -1);
+  return first;
+}
+
+std::size_t World::AllocateBody() {
+  // Last freed slot if any, else a new one
+  if (body_free_head_ < 0) return GrowBodies(1);
+  // the generation was bumped by RemoveBody, the old handles stay stale
+  const auto slot = static_cast<std::size_t>(body_free_head_);
+  body_free_head_ = body_next_free_[slot];
+  body_next_free_[slot] = -1;
+  return slot;
+}
+
+void World::WriteBody(const std::size_t slot, const BodyDesc& desc) {
+  body_positions_[slot] = desc.position;
+  body_velocities_[slot] = desc.velocity;
+  body_forces_[slot] = {0, 0};
+  body_masses_[slot] = desc.mass;
+  body_inverse_masses_[slot] = InverseMass(desc.mass, desc.type);
+  body_types_[slot] = desc.type;
+  body_flags_[slot] = kBodyAlive | kBodyAwake;
+  body_quiet_ticks_[slot] = 0;
+  if (desc.type == BodyType::kStatic) {
+    body_velocities_[slot] = {0, 0};
+    ++static_count_;
+  }
+}
+
+void World::FreeBody(const int slot) {
+  if (IsStatic(slot)) --static_count_;
+  body_masses_[slot] = 0.f;
+  body_inverse_masses_[slot] = 0.f;
+  body_velocities_[slot] = {0, 0};
+  body_forces_[slot] = {0, 0};
+  body_generations_[slot]++;
+  body_flags_[slot] = 0;
+  body_next_free_[slot] = body_free_head_;
+  body_free_head_ = slot;
+}
+
+void World::WakeSlot(const int slot) {
+  body_flags_[slot] |= kBodyAwake;
+  body_quiet_ticks_[slot] = 0;
+}
+
+bool World::IsAsleep(const int slot) const {
+  return sleep_.enabled && (body_flags_[slot] & kBodyAwake) == 0;
+}
+
+[[nodiscard]] BodyIndex World::AddBody(const float mass, const BodyType type) {
+  const std::size_t slot = AllocateBody();
+  WriteBody(slot, BodyDesc{mass, {0, 0}, {0, 0}, type});
+  return BodyIndex{static_cast<int>(slot), body_generations_[slot]};
+}
+
+void World::AddBodies(const std::span<const BodyDesc> descs,
+                      const std::span<BodyIndex> out) {
+  if (out.size() < descs.size()) {
+    throw std::out_of_range("Trying to add bodies with a too small handle span");
+  }
+  std::size_t k = 0;
+  // dead slots first, then the rest in one resize of each column
+  for (; k < descs.size() && body_free_head_ >= 0; ++k) {
+    const std::size_t slot = AllocateBody();
+    WriteBody(slot, descs[k]);
+    out[k] = BodyIndex{static_cast<int>(slot), body_generations_[slot]};
+  }
+  std::size_t slot = GrowBodies(descs.size() - k);
+  for (; k < descs.size(); ++k, ++slot) {
+    WriteBody(slot, descs[k]);
+    out[k] = BodyIndex{static_cast<int>(slot), 0};
+  }
+}
+
+[[nodiscard]] Body World::GetBodyAt(const BodyIndex body_index) {
+  const int slot = BodySlot(body_index, "get");
+  return Body(body_positions_[slot], body_velocities_[slot], body_forces_[slot],
+              body_masses_[slot], body_inverse_masses_[slot],
+              body_types_[slot], body_flags_[slot]);
+}
+
+void World::RemoveBody(const BodyIndex body_index) {
+  FreeBody(BodySlot(body_index, "remove"));
+}
+
+void World::RemoveBodies(const std::span<const BodyIndex> bodies) {
+  // checked one at a time: a handle given twice is stale the second time
+  for (const BodyIndex body : bodies) FreeBody(BodySlot(body, "remove"));
+}
+
+void World::SetBodyType(const BodyIndex body_index, const BodyType type) {
+  const int      slot = BodySlot(body_index, "set the type of");
+  const BodyType old_type = body_types_[slot];
+  if (old_type == type) return;
+  body_types_[slot] = type;
+  body_inverse_masses_[slot] = InverseMass(body_masses_[slot], type);
+  WakeSlot(slot);
+  if (type == BodyType::kStatic) {
+    body_velocities_[slot] = {0, 0};
+    body_forces_[slot] = {0, 0};
+    ++static_count_;
+  } else if (old_type == BodyType::kStatic) {
+    --static_count_;
+  } else {
+    return;
+  }
+
+  // Its colliders change partition, they have no body list: rare enough
+  // for a scan
+  for (int i = 0; i < static_cast<int>(colliders_.size()); ++i) {
+    if (colliders_[i].first.body.index() == slot) SetLayer(i);
+  }
+}
 
-  // colliders storage: stores Collider + generation int (similar to bodies)
-  std::vector<std::pair<Collider, int>> colliders;
+void World::SetSleepSettings(const SleepSettings& settings) {
+  sleep_ = settings;
+  if (sleep_.enabled) return;
+  for (int i = 0; i < static_cast<int>(body_masses_.size()); ++i) {
+    if (body_flags_[i] & kBodyAlive) WakeSlot(i);
+  }
+}
+
+bool World::IsAwake(const BodyIndex body_index) const {
+  return !IsAsleep(BodySlot(body_index, "get"));
+}
+
+void World::WakeBody(const BodyIndex body_index) {
+  WakeSlot(BodySlot(body_index, "wake"));
+}
+
+void World::Tick(const float dt) {
+  // The divide by mass is done once in AddBody/SetMass, dead slots have
+  // zero inverse mass and velocity and don't move
+  const BodySoa bodies{Floats(body_positions_), Floats(body_velocities_),
+                       Floats(body_forces_), body_inverse_masses_.data()};
+  const bool xpbd = solver_.type == SolverType::kXpbd;
+  if (xpbd) {
+    StepXpbd(dt);
+  } else if (sleep_.enabled || static_count_ > 0) {
+    UpdateAwakeSpans();
+    IntegrateSpans(bodies, awake_spans_, dt, *pool_);
+  } else {
+    Integrate(bodies, body_positions_.size(), dt, *pool_);
+  }
+
+  // --- Trigger detection ---
+  FindOverlaps(dt);
+  // also once after the last solid collider is gone, to drop its contacts
+  if (!xpbd && (any_solid_ || !contacts_.empty())) SolveContacts();
+  if (sleep_.enabled) UpdateIslands();
+  DispatchEvents();
+  std::swap(active_pairs_, new_pairs_);
+  UpdateOverlapTable();
+  // once, out of the detection loops
+  if (listener_) listener_->OnContactEvents(events_.View());
+  if (!routes_.empty()) RouteEvents();
+  routed_layers_ = collider_layers_;
+}
+
+void World::StepXpbd(const float dt) {
+  const int n = static_cast<int>(body_masses_.size());
+  if (sleep_.enabled || static_count_ > 0) {
+    UpdateAwakeSpans();
+  } else {
+    // every slot, as Integrate does: dead ones don't move
+    awake_spans_.clear();
+    for (int i = 0; i < n; i += kIntegrationGrain) {
+      awake_spans_.push_back({i, std::min(n, i + kIntegrationGrain)});
+    }
+  }
+  // sleepers were woken above if they had to, the others hold still
+  const float* weights = body_inverse_masses_.data();
+  if (sleep_.enabled) {
+    xpbd_weights_.assign(body_inverse_masses_.begin(), body_inverse_masses_.end());
+    for (int i = 0; i < n; ++i) {
+      if ((body_flags_[i] & kBodyAwake) == 0) xpbd_weights_[i] = 0.f;
+    }
+    weights = xpbd_weights_.data();
+  }
 
-  // active overlapping pairs
-  std::unordered_set<ColliderPair, ColliderPairHasher> activePairs;
+  FindXpbdContacts(dt, weights);
+  const auto alive = [&](const BodyIndex body) {
+    return body_generations_[body.index()] == body.generationIndex() &&
+           (body_flags_[body.index()] & kBodyAlive) != 0;
+  };
+  xpbd_distances_.clear();
+  for (const auto& [desc, generation] : distance_constraints_) {
+    if (desc.a.index() < 0 || !alive(desc.a) || !alive(desc.b)) continue;
+    xpbd_distances_.push_back({desc.a.index(), desc.b.index(), desc.length, desc.compliance});
+  }
+  // in colour order, so that a colour is a contiguous span
+  ColorConstraints(std::span<const Contact>(contacts_), weights, n, contact_colors_);
+  contact_scratch_.resize(contacts_.size());
+  for (std::size_t j = 0; j < contacts_.size(); ++j) {
+    contact_scratch_[j] = contacts_[contact_colors_.order[j]];
+  }
+  std::swap(contacts_, contact_scratch_);
+  ColorConstraints(std::span<const DistanceConstraint>(xpbd_distances_), weights, n,
+                   distance_colors_);
+  xpbd_distance_scratch_.resize(xpbd_distances_.size());
+  for (std::size_t j = 0; j < xpbd_distances_.size(); ++j) {
+    xpbd_distance_scratch_[j] = xpbd_distances_[distance_colors_.order[j]];
+  }
+  std::swap(xpbd_distances_, xpbd_distance_scratch_);
 
-  ContactListener* listener = nullptr;
+  xpbd_previous_.resize(n);
+  const XpbdBodies bodies{body_positions_.data(), body_velocities_.data(),
+                          xpbd_previous_.data(), body_forces_.data(), weights};
+  const int   substeps = std::max(solver_.substeps, 1);
+  const float h = dt / static_cast<float>(substeps);
+  const int   span_count = static_cast<int>(awake_spans_.size());
+  const int   grain = std::max(1, span_count / (4 * pool_->thread_count()));
+  const auto  for_spans = [&](auto&& fn) {
+    pool_->ParallelFor(span_count, grain, [&](const int begin, const int end, int) {
+      for (int s = begin; s < end; ++s) fn(awake_spans_[s].begin, awake_spans_[s].end);
+    });
+  };
+  for (int step = 0; step < substeps; ++step) {
+    for_spans([&](const int first, const int last) { PredictPositions(bodies, first, last, h); });
+    ForEachColorBatch(contact_colors_, [&](const int first, const int last) {
+      ProjectContacts(bodies, std::span<const Contact>(contacts_).subspan(first, last - first),
+                      solver_.contact_compliance, h);
+    });
+    ForEachColorBatch(distance_colors_, [&](const int first, const int last) {
+      ProjectDistances(bodies,
+                       std::span<const DistanceConstraint>(xpbd_distances_)
+                           .subspan(first, last - first),
+                       h);
+    });
+    for_spans([&](const int first, const int last) { UpdateVelocities(bodies, first, last, h); });
+  }
+  for_spans([&](const int first, const int last) {
+    std::fill(body_forces_.begin() + first, body_forces_.begin() + last, core::Vec2F{0, 0});
+  });
 }
 
-// ---------- Body functions (adapted from your existing code) ----------
-[[nodiscard]] BodyIndex AddBody(const float mass) {
-  const auto it = std::ranges::find_if(bodies, [&](const auto& body) {
-    return body.first.IsInvalid();
+void World::FindXpbdContacts(const float dt, const float* weights) {
+  // The broadphases still hold last tick's boxes: every solid pair that
+  // can touch during this tick is within the sum of their radii and of
+  // the distances they can travel. The collider that can travel farther
+  // finds the pair, its box grown by twice its reach covers the other.
+  const int n = static_cast<int>(colliders_.size());
+  const auto mover = [&](const int slot) {
+    const Collider& c = colliders_[slot].first;
+    const int body = c.body.index();
+    return body >= 0 && c.solid && !IsStatic(body) && (body_flags_[body] & kBodyAwake) != 0;
+  };
+  const auto reach = [&](const int slot) {
+    if (!mover(slot)) return 0.f;
+    const int body = colliders_[slot].first.body.index();
+    const core::Vec2F v = body_velocities_[body] + body_forces_[body] * (weights[body] * dt);
+    return std::sqrt(v.magnitude_sqr()) * dt;
+  };
+  // per-thread lists, concatenated and sorted: the order doesn't depend
+  // on the broadphase nor on the threads
+  xpbd_thread_contacts_.resize(pool_->thread_count());
+  for (auto& list : xpbd_thread_contacts_) list.clear();
+  pool_->ParallelFor(n, kQueryGrain, [&](const int begin, const int end, const int thread) {
+    for (int i = begin; i < end; ++i) {
+      if (!mover(i)) continue;
+      const Collider&   c = colliders_[i].first;
+      const core::Vec2F center = body_positions_[c.body.index()];
+      const float       reach_i = reach(i);
+      const Aabb box = Aabb::FromCircle(center, c.circle.radius + 2.f * reach_i);
+      ForEachCandidate(box, kAllCategories, [&](const int j) {
+        const Collider& o = colliders_[j].first;
+        if (j == i || !o.solid) return true;
+        // ties go to the lower slot
+        const float reach_j = reach(j);
+        if (reach_j > reach_i || (reach_j == reach_i && j < i && mover(j))) return true;
+        if (o.body == c.body || !ShouldCollide(c.filter, o.filter)) return true;
+        if (weights[c.body.index()] + weights[o.body.index()] <= 0.f) return true;
+        const float       radius = c.circle.radius + o.circle.radius;
+        const float       limit = radius + reach_i + reach_j;
+        const core::Vec2F d = body_positions_[o.body.index()] - center;
+        if (d.magnitude_sqr() > limit * limit) return true;
+        Contact contact;
+        contact.key = PairKey(std::min(i, j), std::max(i, j));
+        contact.a = colliders_[std::min(i, j)].first.body.index();
+        contact.b = colliders_[std::max(i, j)].first.body.index();
+        contact.radius = radius;
+        xpbd_thread_contacts_[thread].push_back(contact);
+        return true;
+      });
+    }
   });
-  if (it != bodies.end()) {
-    it->first.mass = mass;
-    return BodyIndex{static_cast<int>(std::distance(bodies.begin(), it)), it->second};
+  contacts_.clear();
+  for (const auto& list : xpbd_thread_contacts_) contacts_.insert(contacts_.end(), list.begin(), list.end());
+  std::ranges::sort(contacts_, {}, &Contact::key);
+  // the filter is user code, asked on this thread only
+  if (contact_filter_) {
+    std::erase_if(contacts_, [&](const Contact& c) {
+      return !contact_filter_->ShouldCollide(HandleOf(static_cast<int>(c.key >> 32)),
+                                             HandleOf(static_cast<int>(c.key & 0xFFFFFFFFu)));
+    });
   }
-  auto body = Body(mass);
-  const BodyIndex idx(static_cast<int>(bodies.size()));
-  bodies.emplace_back(body, 0);
-  return idx;
 }
 
-[[nodiscard]] Body& get_body_at(const BodyIndex body_index) {
-  if (body_index.index() < 0 ||
-      body_index.index() >= static_cast<int>(bodies.size()))
-    throw std::out_of_range("Trying to get a body with an out of range index");
+void World::UpdateAwakeSpans() {
+  // Before the integration, the forces of this tick are still there
+  const float max_v2 = sleep_.linear_velocity * sleep_.linear_velocity;
+  const float max_f2 = sleep_.force * sleep_.force;
+  awake_spans_.clear();
+  const int n = static_cast<int>(body_masses_.size());
+  if (sleep_.enabled) {
+    for (int i = 0; i < n; ++i) {
+      if ((body_flags_[i] & kBodyAlive) == 0 || IsStatic(i)) continue;
+      // asleep with a zero velocity: anything else was set by the user
+      if ((body_flags_[i] & kBodyAwake) == 0 &&
+          (!IsZero(body_velocities_[i]) || !IsZero(body_forces_[i]))) {
+        WakeSlot(i);
+      }
+    }
+    if (!distance_constraints_.empty()) {
+      // a sleeper tied to an awake body wakes with it, else the awake end
+      // pulls on an end of zero weight
+      island_parent_.resize(n);
+      for (int i = 0; i < n; ++i) island_parent_[i] = i;
+      UniteConstrainedBodies();
+      // here 1 for the groups with an awake body
+      island_ready_.assign(n, 0);
+      for (int i = 0; i < n; ++i) {
+        if (body_flags_[i] & kBodyAwake) island_ready_[FindRoot(island_parent_, i)] = 1;
+      }
+      for (int i = 0; i < n; ++i) {
+        if ((body_flags_[i] & kBodyAlive) == 0 || IsStatic(i)) continue;
+        if ((body_flags_[i] & kBodyAwake) == 0 && island_ready_[FindRoot(island_parent_, i)]) {
+          WakeSlot(i);
+        }
+      }
+    }
+  }
+  for (int i = 0; i < n; ++i) {
+    if ((body_flags_[i] & kBodyAlive) == 0 || IsStatic(i)) continue;
+    if (sleep_.enabled) {
+      if ((body_flags_[i] & kBodyAwake) == 0) continue;
+      const core::Vec2F& v = body_velocities_[i];
+      const core::Vec2F& f = body_forces_[i];
+      const bool quiet = v.x * v.x + v.y * v.y <= max_v2 &&
+                         f.x * f.x + f.y * f.y <= max_f2;
+      body_quiet_ticks_[i] =
+          quiet ? std::min(body_quiet_ticks_[i] + 1, sleep_.ticks_to_sleep) : 0;
+    }
 
-  if (body_index.generationIndex() != bodies[body_index.index()].second) {
-    throw std::runtime_error("Trying to get a body with an invalid generation index");
+    // extend the last run, cut at the grain so chunks stay in L1
+    if (!awake_spans_.empty() && awake_spans_.back().end == i &&
+        i - awake_spans_.back().begin < kIntegrationGrain) {
+      awake_spans_.back().end = i + 1;
+    } else {
+      awake_spans_.push_back({i, i + 1});
+    }
   }
-  return bodies[body_index.index()].first;
 }
 
-void RemoveBody(const BodyIndex body_index) {
-  if (body_index.index() < 0 ||
-      body_index.index() >= static_cast<int>(bodies.size())) {
-    throw std::out_of_range("Trying to remove a body with an out of range index");
+void World::UpdateIslands() {
+  // Islands of this tick's overlaps decide who sleeps during the next one
+  const int n = static_cast<int>(body_masses_.size());
+  island_parent_.resize(n);
+  for (int i = 0; i < n; ++i) island_parent_[i] = i;
+  for (const auto key : new_pairs_) {
+    const int a = colliders_[key >> 32].first.body.index();
+    const int b = colliders_[key & 0xFFFFFFFFu].first.body.index();
+    // a static body would tie together everything resting on it
+    if (IsStatic(a) || IsStatic(b)) continue;
+    const int root_a = FindRoot(island_parent_, a);
+    const int root_b = FindRoot(island_parent_, b);
+    if (root_a != root_b) island_parent_[root_b] = root_a;
+  }
+  // a rod holds its two bodies as much as an overlap does
+  UniteConstrainedBodies();
+
+  island_ready_.assign(n, 1);
+  for (int i = 0; i < n; ++i) {
+    if ((body_flags_[i] & kBodyAlive) == 0 || IsStatic(i)) continue;
+    const bool ready = (body_flags_[i] & kBodyAwake) == 0 ||
+                       body_quiet_ticks_[i] >= sleep_.ticks_to_sleep;
+    if (!ready) island_ready_[FindRoot(island_parent_, i)] = 0;
   }
-  if (body_index.generationIndex() != bodies[body_index.index()].second) {
-    throw std::runtime_error("Trying to remove a body with an invalid generation index");
+  for (int i = 0; i < n; ++i) {
+    if ((body_flags_[i] & kBodyAlive) == 0 || IsStatic(i)) continue;
+    const bool asleep = (body_flags_[i] & kBodyAwake) == 0;
+    if (island_ready_[FindRoot(island_parent_, i)]) {
+      if (asleep) continue;
+      body_flags_[i] &= static_cast<std::uint8_t>(~kBodyAwake);
+      body_velocities_[i] = {0, 0};
+    } else if (asleep) {
+      WakeSlot(i);
+    }
   }
-  bodies[body_index.index()].first.mass = -1;
-  bodies[body_index.index()].second++;
 }
 
-void Tick(const float dt) {
-  for (auto& key : bodies | std::views::keys) {
-    key.Tick(dt);
+void World::UniteConstrainedBodies() {
+  for (const auto& [desc, generation] : distance_constraints_) {
+    const int a = desc.a.index();
+    const int b = desc.b.index();
+    if (a < 0 || body_generations_[a] != desc.a.generationIndex() ||
+        body_generations_[b] != desc.b.generationIndex()) {
+      continue;
+    }
+    if ((body_flags_[a] & kBodyAlive) == 0 || (body_flags_[b] & kBodyAlive) == 0) continue;
+    if (IsStatic(a) || IsStatic(b)) continue;
+    const int root_a = FindRoot(island_parent_, a);
+    const int root_b = FindRoot(island_parent_, b);
+    if (root_a != root_b) island_parent_[root_b] = root_a;
+  }
+}
+
+void World::FindOverlaps(const float dt) {
+  const int n = static_cast<int>(colliders_.size());
+  collider_x_.resize(n);
+  collider_y_.resize(n);
+  collider_radius_.resize(n);
+  collider_dx_.assign(n, 0.f);
+  collider_dy_.assign(n, 0.f);
+  swept_slots_.clear();
+  any_solid_ = false;
+  collider_frozen_.resize(n);
+  collider_static_.resize(n);
+  bool any_frozen = false;
+  bool statics_moved = false;
+  for (int i = 0; i < n; ++i) {
+    const auto& c = colliders_[i].first;
+    collider_frozen_[i] = 0;
+    collider_static_[i] = 0;
+    if (c.body.index() < 0) {
+      // NaN never overlaps anything, dead slots drop out of the row tests
+      collider_x_[i] = collider_y_[i] = std::numeric_limits<float>::quiet_NaN();
+      collider_radius_[i] = 0.f;
+      continue;
+    }
+    // filter edited in place through GetColliderAt
+    if (c.filter != layers_[collider_layers_[i]].filter) SetLayer(i);
+    any_solid_ |= c.solid;
+    const int   slot = BodySlot(c.body, "get");
+    const auto& pos = body_positions_[slot];
+    const bool  is_static = IsStatic(slot);
+    collider_static_[i] = is_static;
+    if (is_static || IsAsleep(slot)) {
+      // last tick's values, unless the user moved or resized it meanwhile
+      if (pos.x == collider_x_[i] && pos.y == collider_y_[i] &&
+          c.circle.radius == collider_radius_[i]) {
+        collider_frozen_[i] = 1;
+        any_frozen = true;
+        continue;
+      }
+      if (is_static) {
+        statics_moved = true;
+        static_tree_->Move(i, Aabb::FromCircle(pos, c.circle.radius));
+      } else {
+        WakeSlot(slot);
+      }
+    }
+    collider_x_[i] = pos.x;
+    collider_y_[i] = pos.y;
+    collider_radius_[i] = c.circle.radius;
+    if (!continuous_ || is_static) continue;
+    // Semi-implicit Euler: this tick's motion is the new velocity * dt.
+    // Slower colliders can't skip over anything, they stay discrete.
+    const float dx = body_velocities_[slot].x * dt;
+    const float dy = body_velocities_[slot].y * dt;
+    if (dx * dx + dy * dy > c.circle.radius * c.circle.radius) {
+      collider_dx_[i] = dx;
+      collider_dy_[i] = dy;
+      swept_slots_.push_back(i);
+    }
+  }
+  // NaN slots (dead) leave the bounds as they are
+  constexpr float kInf = std::numeric_limits<float>::infinity();
+  center_bounds_ = {{kInf, kInf}, {-kInf, -kInf}};
+  for (int i = 0; i < n; ++i) {
+    center_bounds_.min = {std::min(center_bounds_.min.x, collider_x_[i]),
+                          std::min(center_bounds_.min.y, collider_y_[i])};
+    center_bounds_.max = {std::max(center_bounds_.max.x, collider_x_[i]),
+                          std::max(center_bounds_.max.y, collider_y_[i])};
+  }
+  if (statics_moved) {
+    // Rare (a static was added, moved or resized): nothing from last tick
+    // can be trusted, every collider is tested again
+    std::ranges::fill(collider_frozen_, std::uint8_t{0});
+    any_frozen = false;
+  }
+  const CircleSoa circles{collider_x_.data(), collider_y_.data(),
+                          collider_radius_.data(), collider_dx_.data(),
+                          collider_dy_.data()};
+  const auto swept = [&](const int i) {
+    return collider_dx_[i] != 0.f || collider_dy_[i] != 0.f;
+  };
+  // a swept pair missed by the test at the end of the tick may have
+  // touched before
+  const auto sweep = [&](const int a, const int b, const std::size_t k) {
+    if ((overlap_mask_[k >> 6] >> (k & 63) & 1) != 0) return;
+    if (TimeOfImpact(circles, a, b) <= 1.f) overlap_mask_[k >> 6] |= std::uint64_t{1} << (k & 63);
+  };
+
+  // Both paths report the overlaps in increasing (i, j) order, so
+  // new_pairs_ comes out sorted. Two colliders that haven't moved keep
+  // last tick's state, two static ones are never tested.
+  new_pairs_.clear();
+  const auto skip = [&](const int i, const int j) {
+    return (collider_frozen_[i] && collider_frozen_[j]) ||
+           (collider_static_[i] && collider_static_[j]);
+  };
+  const auto vetoed = [&](const int i, const int j) {
+    return contact_filter_ && !contact_filter_->ShouldCollide(HandleOf(i), HandleOf(j));
+  };
+
+  if (broad_phase_type_ == BroadPhaseType::kBruteForce) {
+    // naive O(n^2), one vectorized row per collider. The rows stay whole,
+    // the filter is applied to their hits
+    for (int i = 0; i < n; ++i) {
+      // skip invalid
+      if (colliders_[i].first.body.index() < 0) continue;
+      const CollisionFilter& filter = colliders_[i].first.filter;
+      overlap_mask_.resize(MaskWordCount(static_cast<std::size_t>(n - i - 1)));
+      OverlapRow(circles, i, i + 1, n, overlap_mask_.data());
+      if (swept(i)) {
+        for (int j = i + 1; j < n; ++j) sweep(i, j, static_cast<std::size_t>(j - i - 1));
+      } else {
+        for (auto it = std::ranges::upper_bound(swept_slots_, i); it != swept_slots_.end(); ++it) {
+          sweep(i, *it, static_cast<std::size_t>(*it - i - 1));
+        }
+      }
+      ForEachSetBit(overlap_mask_, [&](const std::size_t k) {
+        const int j = i + 1 + static_cast<int>(k);
+        if (skip(i, j) || !ShouldCollide(filter, colliders_[j].first.filter) ||
+            vetoed(i, j)) {
+          return;
+        }
+        new_pairs_.push_back(PairKey(i, j));
+      });
+    }
+    if (any_frozen) MergeFrozenPairs();
+    return;
   }
 
-  // --- Trigger detection (naive O(n^2) for simplicity) ---
-  std::unordered_set<ColliderPair, ColliderPairHasher> newPairs;
+  // Moving colliders only: the static ones live in static_tree_
+  const auto moving = [&](const int i) {
+    return colliders_[i].first.body.index() >= 0 && !collider_frozen_[i] &&
+           !collider_static_[i];
+  };
+  for (int i = 0; i < n; ++i) {
+    if (!moving(i)) continue;
+    BroadPhase* broad_phase = layers_[collider_layers_[i]].broad_phase.get();
+    if (!broad_phase) continue;
+    broad_phase->Move(i, SweptAabb(i));
+  }
+  // Pairs are only enumerated within a layer and between layers whose
+  // bits match, every candidate already passes the filter
+  candidate_pairs_.clear();
+  for (const Layer& layer : layers_) {
+    if (layer.broad_phase) layer.broad_phase->FindPairs(candidate_pairs_);
+  }
+  if (layers_.size() > 1) FindCrossLayerPairs();
+  if (static_count_ > 0) {
+    for (int i = 0; i < n; ++i) {
+      if (!moving(i)) continue;
+      const CollisionFilter& filter = colliders_[i].first.filter;
+      static_tree_->Query(SweptAabb(i), [&](const int s) {
+        if (!ShouldCollide(filter, colliders_[s].first.filter)) return;
+        candidate_pairs_.push_back(i < s ? ProxyPair{i, s} : ProxyPair{s, i});
+      });
+    }
+  }
+  // same (i, j) order as the naive loop, so the event stream is identical
+  candidate_keys_.resize(candidate_pairs_.size());
+  std::ranges::transform(candidate_pairs_, candidate_keys_.begin(),
+                         [](const ProxyPair& p) { return PairKey(p.a, p.b); });
+  RadixSort(candidate_keys_, sort_scratch_, 0, 64, pool_);
+  std::ranges::transform(candidate_keys_, candidate_pairs_.begin(), [](const std::uint64_t key) {
+    return ProxyPair{static_cast<int>(key >> 32), static_cast<int>(key & 0xFFFFFFFFu)};
+  });
+  if (any_frozen || contact_filter_) {
+    std::erase_if(candidate_pairs_, [&](const ProxyPair& p) {
+      return skip(p.a, p.b) || vetoed(p.a, p.b);
+    });
+  }
+  overlap_mask_.resize(MaskWordCount(candidate_pairs_.size()));
+  OverlapPairs(circles, candidate_pairs_.data(), candidate_pairs_.size(),
+               overlap_mask_.data());
+  if (!swept_slots_.empty()) {
+    for (std::size_t k = 0; k < candidate_pairs_.size(); ++k) {
+      const ProxyPair& p = candidate_pairs_[k];
+      if (swept(p.a) || swept(p.b)) sweep(p.a, p.b, k);
+    }
+  }
+  ForEachSetBit(overlap_mask_, [&](const std::size_t k) {
+    const ProxyPair& p = candidate_pairs_[k];
+    if (!skip(p.a, p.b)) new_pairs_.push_back(PairKey(p.a, p.b));
+  });
+  if (any_frozen) MergeFrozenPairs();
+}
 
-  const int n = static_cast<int>(colliders.size());
+void World::FindCrossLayerPairs() {
+  // For every pair of layers whose bits match, the members of one query
+  // the broadphase of the other with their swept boxes. The broadphases
+  // were given these boxes by Move this tick.
+  const int n = static_cast<int>(colliders_.size());
+  cross_boxes_.resize(colliders_.size());
+  for (Layer& layer : layers_) layer.members.clear();
   for (int i = 0; i < n; ++i) {
-    // skip invalid
-    if (colliders[i].first.body.index() < 0) continue;
-    for (int j = i + 1; j < n; ++j) {
-      if (colliders[j].first.body.index() < 0) continue;
-
-      const auto& A = colliders[i].first;
-      const auto& B = colliders[j].first;
-
-      const auto& posA = get_body_at(A.body).position;
-      const auto& posB = get_body_at(B.body).position;
-
-      const float r = A.circle.radius + B.circle.radius;
-      const float dx = posA.x - posB.x;
-      const float dy = posA.y - posB.y;
-      const float dist2 = dx*dx + dy*dy;
-
-      if (dist2 <= r * r) {
-        ColliderPair p{ ColliderIndex(i), ColliderIndex(j) };
-        newPairs.insert(p);
-        // Enter event
-        if (activePairs.find(p) == activePairs.end() && listener) {
-          listener->OnTriggerEnter(p.a, p.b);
+    if (colliders_[i].first.body.index() < 0 || collider_static_[i]) continue;
+    layers_[collider_layers_[i]].members.push_back(i);
+    cross_boxes_[i] = SweptAabb(i);
+  }
+  for (std::size_t la = 0; la < layers_.size(); ++la) {
+    for (std::size_t lb = la + 1; lb < layers_.size(); ++lb) {
+      if (!ShouldCollide(layers_[la].filter, layers_[lb].filter)) continue;
+      Layer& a = layers_[la];
+      Layer& b = layers_[lb];
+      const auto indexed = [](const Layer& layer) {
+        return layer.broad_phase && layer.broad_phase->HasSpatialQuery();
+      };
+      if (indexed(a) || indexed(b)) {
+        // the smaller layer queries, when both can be queried
+        const bool into_b =
+            indexed(b) && (!indexed(a) || a.members.size() <= b.members.size());
+        const Layer& from = into_b ? a : b;
+        BroadPhase&  into = *(into_b ? b : a).broad_phase;
+        for (const int i : from.members) {
+          auto report = [&](const int j) {
+            if (!(collider_frozen_[i] && collider_frozen_[j])) {
+              candidate_pairs_.push_back(i < j ? ProxyPair{i, j} : ProxyPair{j, i});
+            }
+            return true;
+          };
+          FunctionQueryCallback callback(report);
+          into.Query(cross_boxes_[i], callback);
+        }
+        continue;
+      }
+      // Neither layer can be queried (it ignores itself, or its
+      // broadphase is a sweep): bipartite sweep along the wider axis of the
+      // two layers, the box that starts first meets every box of the other
+      // layer starting before its end
+      Aabb bounds{{std::numeric_limits<float>::max(), std::numeric_limits<float>::max()},
+                  {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()}};
+      for (const Layer* layer : {&a, &b}) {
+        for (const int i : layer->members) {
+          bounds.min.x = std::min(bounds.min.x, cross_boxes_[i].min.x);
+          bounds.min.y = std::min(bounds.min.y, cross_boxes_[i].min.y);
+          bounds.max.x = std::max(bounds.max.x, cross_boxes_[i].max.x);
+          bounds.max.y = std::max(bounds.max.y, cross_boxes_[i].max.y);
         }
       }
+      const bool along_y = bounds.max.y - bounds.min.y > bounds.max.x - bounds.min.x;
+      const auto lo = [&](const int i) {
+        return along_y ? cross_boxes_[i].min.y : cross_boxes_[i].min.x;
+      };
+      const auto hi = [&](const int i) {
+        return along_y ? cross_boxes_[i].max.y : cross_boxes_[i].max.x;
+      };
+      for (Layer* layer : {&a, &b}) {
+        std::ranges::sort(layer->members, [&](const int i, const int j) { return lo(i) < lo(j); });
+      }
+      const auto scan = [&](const int i, const std::vector<int>& others, std::size_t k) {
+        for (; k < others.size() && lo(others[k]) <= hi(i); ++k) {
+          const int j = others[k];
+          if (collider_frozen_[i] && collider_frozen_[j]) continue;
+          if (!cross_boxes_[i].Overlaps(cross_boxes_[j])) continue;
+          candidate_pairs_.push_back(i < j ? ProxyPair{i, j} : ProxyPair{j, i});
+        }
+      };
+      std::size_t i = 0;
+      std::size_t j = 0;
+      while (i < a.members.size() && j < b.members.size()) {
+        if (lo(a.members[i]) <= lo(b.members[j])) {
+          scan(a.members[i++], b.members, j);
+        } else {
+          scan(b.members[j++], a.members, i);
+        }
+      }
+    }
+  }
+}
+
+Aabb World::SweptAabb(const int slot) const {
+  // the collider came from its position minus the motion
+  const Aabb  box = Aabb::FromCircle({collider_x_[slot], collider_y_[slot]},
+                                     collider_radius_[slot]);
+  const float dx = collider_dx_[slot];
+  const float dy = collider_dy_[slot];
+  return {{std::min(box.min.x, box.min.x - dx), std::min(box.min.y, box.min.y - dy)},
+          {std::max(box.max.x, box.max.x - dx), std::max(box.max.y, box.max.y - dy)}};
+}
+
+void World::MergeFrozenPairs() {
+  frozen_pairs_.clear();
+  for (const auto key : active_pairs_) {
+    if (collider_frozen_[key >> 32] && collider_frozen_[key & 0xFFFFFFFFu]) {
+      frozen_pairs_.push_back(key);
     }
   }
+  if (frozen_pairs_.empty()) return;
+  // both sorted
+  pair_scratch_.resize(new_pairs_.size() + frozen_pairs_.size());
+  std::ranges::merge(new_pairs_, frozen_pairs_, pair_scratch_.begin());
+  std::swap(new_pairs_, pair_scratch_);
+}
 
-  // Exit events: pairs that were active but not in newPairs
-  for (const auto& oldP : activePairs) {
-    if (newPairs.find(oldP) == newPairs.end() && listener) {
-      listener->OnTriggerExit(oldP.a, oldP.b);
+void World::SolveContacts() {
+  // Contacts in key order, each one takes over the impulse of last tick's
+  // contact with the same key
+  std::swap(contacts_, previous_contacts_);
+  contacts_.clear();
+  std::size_t previous = 0;
+  for (const auto key : new_pairs_) {
+    const int       ia = static_cast<int>(key >> 32);
+    const int       ib = static_cast<int>(key & 0xFFFFFFFFu);
+    const Collider& ca = colliders_[ia].first;
+    const Collider& cb = colliders_[ib].first;
+    if (!ca.solid || !cb.solid) continue;
+    // a resting pair of sleepers stays as it is
+    if (collider_frozen_[ia] && collider_frozen_[ib]) continue;
+    Contact contact;
+    contact.key = key;
+    contact.a = ca.body.index();
+    contact.b = cb.body.index();
+    if (contact.a == contact.b ||
+        body_inverse_masses_[contact.a] + body_inverse_masses_[contact.b] <= 0.f) {
+      continue;
+    }
+    // swept pairs may have touched during the tick only
+    if (!CircleManifold(body_positions_[contact.a], ca.circle.radius,
+                        body_positions_[contact.b], cb.circle.radius, contact)) {
+      continue;
+    }
+    while (previous < previous_contacts_.size() && previous_contacts_[previous].key < key) {
+      ++previous;
+    }
+    if (solver_.warm_starting && previous < previous_contacts_.size() &&
+        previous_contacts_[previous].key == key) {
+      contact.impulse = previous_contacts_[previous].impulse;
     }
+    contacts_.push_back(contact);
   }
+  if (contacts_.empty()) return;
 
-  activePairs = std::move(newPairs);
+  // Colour order, as columns. The impulses go back to contacts_, in key
+  // order for the next tick.
+  ColorConstraints(std::span<const Contact>(contacts_), body_inverse_masses_.data(),
+                   body_masses_.size(), contact_colors_);
+  const int m = static_cast<int>(contacts_.size());
+  ContactColumns& columns = contact_columns_;
+  columns.a.resize(m);
+  columns.b.resize(m);
+  columns.normal_x.resize(m);
+  columns.normal_y.resize(m);
+  columns.radius.resize(m);
+  columns.normal_mass.resize(m);
+  columns.bounce.resize(m);
+  columns.impulse.resize(m);
+  for (int j = 0; j < m; ++j) {
+    const Contact& c = contacts_[contact_colors_.order[j]];
+    columns.a[j] = c.a;
+    columns.b[j] = c.b;
+    columns.normal_x[j] = c.normal.x;
+    columns.normal_y[j] = c.normal.y;
+    columns.radius[j] = c.radius;
+    columns.impulse[j] = c.impulse;
+  }
+  const ContactSoa soa{columns.a.data(),           columns.b.data(),
+                       columns.normal_x.data(),    columns.normal_y.data(),
+                       columns.radius.data(),      columns.normal_mass.data(),
+                       columns.bounce.data(),      columns.impulse.data()};
+  const ContactBodies bodies{body_positions_.data(), body_velocities_.data(),
+                             body_inverse_masses_.data()};
+
+  pool_->ParallelFor(m, kColorGrain, [&](const int begin, const int end, int) {
+    PrepareContacts(bodies, soa, begin, end, solver_);
+  });
+  ForEachColorBatch(contact_colors_, [&](const int first, const int last) {
+    WarmStartContacts(bodies, soa, first, last);
+  });
+  for (int i = 0; i < solver_.velocity_iterations; ++i) {
+    ForEachColorBatch(contact_colors_, [&](const int first, const int last) {
+      SolveContactVelocities(bodies, soa, first, last);
+    });
+  }
+  for (int i = 0; i < solver_.position_iterations; ++i) {
+    ForEachColorBatch(contact_colors_, [&](const int first, const int last) {
+      SolveContactPositions(bodies, soa, first, last, solver_);
+    });
+  }
+  for (int j = 0; j < m; ++j) contacts_[contact_colors_.order[j]].impulse = columns.impulse[j];
 }
 
-// ---------- Collider functions ----------
-[[nodiscard]] ColliderIndex AddCollider(const BodyIndex body, const float radius) {
-  // try to reuse
-  const auto it = std::ranges::find_if(colliders, [&](const auto& c) {
-    return c.first.body.index() < 0;
+template <typename Fn>
+void World::ForEachColorBatch(const ConstraintColors& colors, Fn&& fn) {
+  for (int g = 0; g < colors.GroupCount(); ++g) {
+    const int first = colors.offsets[g];
+    const int count = colors.offsets[g + 1] - first;
+    if (colors.IsSerial(g)) {
+      // its constraints may share bodies: one at a time, out of the SIMD
+      // batches
+      for (int k = first; k < first + count; ++k) fn(k, k + 1);
+      continue;
+    }
+    pool_->ParallelFor(count, kColorGrain, [&](const int begin, const int end, int) {
+      fn(first + begin, first + end);
+    });
+  }
+}
+
+void World::DispatchEvents() {
+  // Linear merge against last tick's list: only in new_pairs_ = enter,
+  // only in active_pairs_ = exit, in both = stay. Both lists are sorted,
+  // so are the events
+  // Enters and stays carry the handles AddCollider returned. Exits carry
+  // the ones of last tick's table: a removed collider keeps the handle it
+  // was known by, even once its slot is reused
+  events_.Clear();
+  const auto event = [&](const std::uint64_t key) {
+    return ContactEvent{HandleOf(static_cast<int>(key >> 32)),
+                        HandleOf(static_cast<int>(key & 0xFFFFFFFFu))};
+  };
+  const auto previous = [&](const int slot) {
+    return ColliderIndex{slot, overlap_generations_[slot]};
+  };
+  const auto previous_event = [&](const std::uint64_t key) {
+    return ContactEvent{previous(static_cast<int>(key >> 32)),
+                        previous(static_cast<int>(key & 0xFFFFFFFFu))};
+  };
+  const auto reused = [&](const std::uint64_t key) {
+    const int a = static_cast<int>(key >> 32);
+    const int b = static_cast<int>(key & 0xFFFFFFFFu);
+    return overlap_generations_[a] != colliders_[a].second ||
+           overlap_generations_[b] != colliders_[b].second;
+  };
+  std::size_t i = 0;
+  std::size_t j = 0;
+  while (i < new_pairs_.size() || j < active_pairs_.size()) {
+    if (j == active_pairs_.size() ||
+        (i < new_pairs_.size() && new_pairs_[i] < active_pairs_[j])) {
+      events_.enters.push_back(event(new_pairs_[i]));
+      ++i;
+    } else if (i == new_pairs_.size() || active_pairs_[j] < new_pairs_[i]) {
+      events_.exits.push_back(previous_event(active_pairs_[j]));
+      ++j;
+    } else if (reused(new_pairs_[i])) {
+      // same slots, not the same colliders: the old pair ends, a new one starts
+      events_.exits.push_back(previous_event(active_pairs_[j]));
+      events_.enters.push_back(event(new_pairs_[i]));
+      ++i;
+      ++j;
+    } else {
+      if (stay_events_) events_.stays.push_back(event(new_pairs_[i]));
+      ++i;
+      ++j;
+    }
+  }
+}
+
+void World::UpdateOverlapTable() {
+  // Counting sort of both ends of every pair. The keys are sorted by
+  // (a, b), so every list comes out sorted too
+  const int n = static_cast<int>(colliders_.size());
+  overlap_offsets_.assign(n + 1, 0);
+  for (const auto key : active_pairs_) {
+    ++overlap_offsets_[(key >> 32) + 1];
+    ++overlap_offsets_[(key & 0xFFFFFFFFu) + 1];
+  }
+  std::inclusive_scan(overlap_offsets_.begin(), overlap_offsets_.end(),
+                      overlap_offsets_.begin());
+  overlap_ids_.resize(overlap_offsets_[n], ColliderIndex{-1});
+  overlap_cursor_.assign(overlap_offsets_.begin(), overlap_offsets_.end() - 1);
+  for (const auto key : active_pairs_) {
+    const int a = static_cast<int>(key >> 32);
+    const int b = static_cast<int>(key & 0xFFFFFFFFu);
+    overlap_ids_[overlap_cursor_[a]++] = HandleOf(b);
+    overlap_ids_[overlap_cursor_[b]++] = HandleOf(a);
+  }
+  overlap_generations_.resize(n);
+  for (int i = 0; i < n; ++i) overlap_generations_[i] = colliders_[i].second;
+}
+
+bool World::IsOverlapping(const ColliderIndex idx) const {
+  return OverlapCount(idx) > 0;
+}
+
+int World::OverlapCount(const ColliderIndex idx) const {
+  return static_cast<int>(GetOverlaps(idx).size());
+}
+
+std::span<const ColliderIndex> World::GetOverlaps(const ColliderIndex idx) const {
+  const int slot = ColliderSlot(idx, "query");
+  // added, or its slot reused, since the last Tick
+  if (slot >= static_cast<int>(overlap_generations_.size()) ||
+      overlap_generations_[slot] != idx.generationIndex()) {
+    return {};
+  }
+  return std::span(overlap_ids_).subspan(overlap_offsets_[slot],
+                                         overlap_offsets_[slot + 1] - overlap_offsets_[slot]);
+}
+
+template <typename Test>
+int World::Collect(const Aabb& aabb, const std::span<ColliderIndex> out,
+                   const std::uint32_t categories, Test&& test) const {
+  int count = 0;
+  if (out.empty()) return 0;
+  ForEachCandidate(aabb, categories, [&](const int slot) {
+    const Collider& c = colliders_[slot].first;
+    if (!test(body_positions_[c.body.index()], c.circle.radius)) return true;
+    out[count++] = HandleOf(slot);
+    return count < static_cast<int>(out.size());
+  });
+  return count;
+}
+
+int World::QueryAABB(const Aabb& aabb, const std::span<ColliderIndex> out,
+                     const std::uint32_t categories) const {
+  return Collect(aabb, out, categories, [&](const core::Vec2F& center, const float radius) {
+    // closest point of the box
+    const core::Vec2F closest{std::clamp(center.x, aabb.min.x, aabb.max.x),
+                              std::clamp(center.y, aabb.min.y, aabb.max.y)};
+    return (center - closest).magnitude_sqr() <= radius * radius;
   });
-  if (it != colliders.end()) {
-    it->first.body = body;
-    it->first.circle.radius = radius;
-    return ColliderIndex{static_cast<int>(std::distance(colliders.begin(), it)), it->second};
+}
+
+int World::QueryCircle(const core::Vec2F center, const float radius,
+                       const std::span<ColliderIndex> out,
+                       const std::uint32_t categories) const {
+  return Collect(Aabb::FromCircle(center, radius), out, categories,
+                 [&](const core::Vec2F& other, const float other_radius) {
+                   const float sum = radius + other_radius;
+                   return (center - other).magnitude_sqr() <= sum * sum;
+                 });
+}
+
+int World::QueryPoint(const core::Vec2F point, const std::span<ColliderIndex> out,
+                      const std::uint32_t categories) const {
+  return QueryCircle(point, 0.f, out, categories);
+}
+
+bool World::Raycast(const Ray& ray, RayCastHit& hit, const std::uint32_t categories) const {
+  hit = RayCastHit{};
+  const core::Vec2F d = ray.end - ray.origin;
+  const float a = d.magnitude_sqr();
+  if (!(a > 0.f)) return false;
+  const Aabb bounds{{std::min(ray.origin.x, ray.end.x), std::min(ray.origin.y, ray.end.y)},
+                    {std::max(ray.origin.x, ray.end.x), std::max(ray.origin.y, ray.end.y)}};
+  int best = -1;
+  ForEachCandidate(bounds, categories, [&](const int slot) {
+    // |origin + t d - center|^2 = r^2, first root
+    const Collider& c = colliders_[slot].first;
+    const core::Vec2F& center = body_positions_[c.body.index()];
+    const core::Vec2F f = ray.origin - center;
+    const float b = f.Dot(d);
+    const float cc = f.magnitude_sqr() - c.circle.radius * c.circle.radius;
+    if (cc <= 0.f) return true; // starts inside
+    const float disc = b * b - a * cc;
+    if (disc < 0.f) return true;
+    const float t = (-b - std::sqrt(disc)) / a;
+    if (t < 0.f || t > 1.f) return true;
+    // ties go to the lowest slot, whatever the broadphase order
+    if (best >= 0 && (t > hit.fraction || (t == hit.fraction && slot > best))) return true;
+    best = slot;
+    hit.fraction = t;
+    hit.point = ray.origin + d * t;
+    hit.normal = c.circle.radius > 0.f ? (hit.point - center) / c.circle.radius
+                                       : core::Vec2F{0, 0};
+    return true;
+  });
+  if (best < 0) return false;
+  hit.collider = HandleOf(best);
+  return true;
+}
+
+int World::KNearest(const core::Vec2F point, const std::span<ColliderIndex> out,
+                    const std::uint32_t categories) const {
+  // Growing boxes until k centers lie within the half side, or the box
+  // holds every collider. The first half side is the one of a box holding
+  // k centers at last tick's mean density. out is kept as a max-heap on
+  // the distance across the passes, a pass only adds the centers that
+  // were outside the previous box.
+  const int k = static_cast<int>(out.size());
+  if (k == 0 || live_collider_count_ == 0) return 0;
+  const auto distance_sqr = [&](const ColliderIndex idx) {
+    return (body_positions_[colliders_[idx.index()].first.body.index()] - point).magnitude_sqr();
+  };
+  const auto closer = [&](const ColliderIndex a, const ColliderIndex b) {
+    const float da = distance_sqr(a);
+    const float db = distance_sqr(b);
+    return da < db || (da == db && a.index() < b.index());
+  };
+  // Chebyshev distance: inside the box of half side h when <= h
+  const auto reach = [&](const int slot) {
+    const core::Vec2F d = body_positions_[colliders_[slot].first.body.index()] - point;
+    return std::max(std::abs(d.x), std::abs(d.y));
+  };
+
+  float half = 1.f;
+  const Aabb& b = center_bounds_;
+  const float area = (b.max.x - b.min.x) * (b.max.y - b.min.y);
+  if (area > 0.f && std::isfinite(area)) {
+    // from outside the bounds, their distance first
+    const float outside = std::max({b.min.x - point.x, point.x - b.max.x,
+                                    b.min.y - point.y, point.y - b.max.y, 0.f});
+    half = outside + 0.5f * std::sqrt(static_cast<float>(k) * area /
+                                      static_cast<float>(live_collider_count_));
   }
-  Collider c;
-  c.body = body;
-  c.circle.radius = radius;
-  const ColliderIndex idx(static_cast<int>(colliders.size()));
-  colliders.emplace_back(c, 0);
-  return idx;
+
+  int   count = 0;
+  float inner = -1.f; // half side of the previous box
+  bool  last = false;
+  for (;; inner = half, half *= 2.f) {
+    int seen = 0;
+    int beyond = 0; // centers out of the box
+    ForEachCandidate(Aabb::FromCircle(point, half), kAllCategories, [&](const int slot) {
+      ++seen;
+      const Collider& c = colliders_[slot].first;
+      if ((c.filter.category & categories) == 0) return true;
+      const float r = reach(slot);
+      // added by an earlier pass, or left to a later one
+      if (r <= inner) return true;
+      if (r > half && !last) {
+        ++beyond;
+        return true;
+      }
+      const ColliderIndex idx = HandleOf(slot);
+      if (count < k) {
+        out[count++] = idx;
+        std::ranges::push_heap(out.first(count), closer);
+      } else if (closer(idx, out.front())) {
+        std::ranges::pop_heap(out, closer);
+        out.back() = idx;
+        std::ranges::push_heap(out, closer);
+      }
+      return true;
+    });
+    // a center within half is in the box, nothing outside can be closer
+    if (last || std::isinf(half)) break;
+    if (count == k && distance_sqr(out.front()) < half * half) break;
+    // every collider reported: one more pass adds the centers out of the box
+    if (seen >= live_collider_count_) {
+      if (beyond == 0) break;
+      last = true;
+    }
+  }
+  std::ranges::sort_heap(out.first(count), closer);
+  return count;
+}
+
+void World::QueryAABBs(const std::span<const Aabb> boxes, const std::span<ColliderIndex> out,
+                       const std::span<int> counts, const std::uint32_t categories) const {
+  if (boxes.empty()) return;
+  if (counts.size() < boxes.size()) {
+    throw std::out_of_range("Trying to query boxes with a too small count span");
+  }
+  const std::size_t slice = out.size() / boxes.size();
+  pool_->ParallelFor(static_cast<int>(boxes.size()), kQueryGrain,
+                     [&](const int begin, const int end, int) {
+                       for (int k = begin; k < end; ++k) {
+                         counts[k] = QueryAABB(boxes[k], out.subspan(k * slice, slice),
+                                               categories);
+                       }
+                     });
+}
+
+void World::Raycasts(const std::span<const Ray> rays, const std::span<RayCastHit> hits,
+                     const std::uint32_t categories) const {
+  if (hits.size() < rays.size()) {
+    throw std::out_of_range("Trying to cast rays with a too small hit span");
+  }
+  pool_->ParallelFor(static_cast<int>(rays.size()), kQueryGrain,
+                     [&](const int begin, const int end, int) {
+                       for (int k = begin; k < end; ++k) Raycast(rays[k], hits[k], categories);
+                     });
+}
+
+void ContactListener::OnContactEvents(const ContactEvents& events) {
+  for (const ContactEvent& e : events.enters) OnTriggerEnter(e.a, e.b);
+  for (const ContactEvent& e : events.exits) OnTriggerExit(e.a, e.b);
+}
+
+void World::SetStayEvents(const bool enabled) {
+  stay_events_ = enabled;
+}
+
+void World::SetContinuousCollision(const bool enabled) {
+  continuous_ = enabled;
+}
+
+void World::DrainContactEvents(ContactEventBuffer& out) {
+  out.Clear();
+  std::swap(events_, out);
+}
+
+void World::Subscribe(const ColliderIndex collider, ContactListener* listener) {
+  ColliderSlot(collider, "subscribe to");
+  collider_subscriptions_.emplace_back(collider, RouteOf(listener));
+  routes_dirty_ = true;
+}
+
+void World::SubscribeCategories(const std::uint32_t categories,
+                                ContactListener* listener) {
+  category_subscriptions_.emplace_back(categories, RouteOf(listener));
+  routes_dirty_ = true;
+}
+
+void World::Unsubscribe(ContactListener* listener) {
+  const auto it = std::ranges::find(routes_, listener, &Route::listener);
+  if (it == routes_.end()) return;
+  const int route = static_cast<int>(it - routes_.begin());
+  routes_.erase(it);
+  // ids past the erased route shift down by one
+  const auto forget = [route](auto& subscriptions) {
+    std::erase_if(subscriptions, [route](const auto& s) { return s.second == route; });
+    for (auto& s : subscriptions) {
+      if (s.second > route) --s.second;
+    }
+  };
+  forget(collider_subscriptions_);
+  forget(category_subscriptions_);
+  routes_dirty_ = true;
+}
+
+int World::RouteOf(ContactListener* listener) {
+  const auto it = std::ranges::find(routes_, listener, &Route::listener);
+  if (it != routes_.end()) return static_cast<int>(it - routes_.begin());
+  routes_.push_back(Route{listener, {}, 0});
+  return static_cast<int>(routes_.size()) - 1;
+}
+
+void World::BuildRoutes() {
+  // Subscriptions sorted by collider slot, offsets[slot] is the first
+  std::ranges::sort(collider_subscriptions_, {},
+                    [](const auto& s) { return s.first.index(); });
+  collider_route_offsets_.assign(colliders_.size() + 1, 0);
+  collider_route_ids_.clear();
+  collider_route_generations_.clear();
+  for (const auto& [collider, route] : collider_subscriptions_) {
+    ++collider_route_offsets_[collider.index() + 1];
+    collider_route_ids_.push_back(route);
+    collider_route_generations_.push_back(collider.generationIndex());
+  }
+  std::inclusive_scan(collider_route_offsets_.begin(), collider_route_offsets_.end(),
+                      collider_route_offsets_.begin());
+
+  // Category subscriptions resolved once per layer
+  layer_route_offsets_.assign(1, 0);
+  layer_route_ids_.clear();
+  for (const Layer& layer : layers_) {
+    for (const auto& [categories, route] : category_subscriptions_) {
+      if (layer.filter.category & categories) layer_route_ids_.push_back(route);
+    }
+    layer_route_offsets_.push_back(static_cast<int>(layer_route_ids_.size()));
+  }
+  routes_dirty_ = false;
+}
+
+void World::RouteEvents() {
+  if (routes_dirty_) BuildRoutes();
+  for (Route& r : routes_) r.events.Clear();
+
+  // Each event goes to the routes of its two colliders and of their
+  // layers, once per route: the cost follows the matches, not the number
+  // of listeners. A slot is shared by the colliders it held: the
+  // subscriptions match the event's handle, and a removed collider is
+  // routed by the layer it had, not by the one of its slot's new collider
+  const auto visit = [&](const std::vector<int>& offsets, const std::vector<int>& ids,
+                         const int key, const int generation,
+                         std::vector<ContactEvent> ContactEventBuffer::*list,
+                         const ContactEvent& e) {
+    if (key < 0 || key + 1 >= static_cast<int>(offsets.size())) return;
+    for (int k = offsets[key]; k < offsets[key + 1]; ++k) {
+      if (generation >= 0 && collider_route_generations_[k] != generation) continue;
+      Route& r = routes_[ids[k]];
+      if (r.stamp == route_stamp_) continue;
+      r.stamp = route_stamp_;
+      (r.events.*list).push_back(e);
+    }
+  };
+  const auto route = [&](const std::vector<ContactEvent>& events,
+                         std::vector<ContactEvent> ContactEventBuffer::*list) {
+    for (const ContactEvent& e : events) {
+      ++route_stamp_;
+      for (const ColliderIndex c : {e.a, e.b}) {
+        const int slot = c.index();
+        const bool removed = c.generationIndex() != colliders_[slot].second &&
+                             slot < static_cast<int>(routed_layers_.size());
+        visit(collider_route_offsets_, collider_route_ids_, slot, c.generationIndex(),
+              list, e);
+        visit(layer_route_offsets_, layer_route_ids_,
+              removed ? routed_layers_[slot] : collider_layers_[slot], -1, list, e);
+      }
+    }
+  };
+  route(events_.enters, &ContactEventBuffer::enters);
+  route(events_.stays, &ContactEventBuffer::stays);
+  route(events_.exits, &ContactEventBuffer::exits);
+
+  for (const Route& r : routes_) {
+    const ContactEvents view = r.events.View();
+    if (view.enters.empty() && view.stays.empty() && view.exits.empty()) continue;
+    r.listener->OnContactEvents(view);
+  }
+
+  if (prune_subscriptions_) {
+    // their exit events are out, the slots may be reused
+    const auto removed = std::erase_if(collider_subscriptions_, [this](const auto& s) {
+      return s.first.generationIndex() != colliders_[s.first.index()].second;
+    });
+    routes_dirty_ = routes_dirty_ || removed > 0;
+    prune_subscriptions_ = false;
+  }
+}
+
+// ---------- Collider functions ----------
+int World::ColliderSlot(const ColliderIndex idx, const char* what) const {
+  if (idx.index() < 0 || idx.index() >= static_cast<int>(colliders_.size())) {
+    throw std::out_of_range(std::string("Trying to ") + what +
+                            " a collider with an out of range index");
+  }
+  if (idx.generationIndex() != colliders_[idx.index()].second) {
+    throw std::runtime_error(std::string("Trying to ") + what +
+                             " a collider with an invalid generation index");
+  }
+  return idx.index();
+}
+
+int World::AllocateCollider() {
+  // reuse the last freed slot
+  int slot = collider_free_head_;
+  if (slot >= 0) {
+    collider_free_head_ = collider_next_free_[slot];
+    collider_next_free_[slot] = -1;
+  } else {
+    slot = static_cast<int>(colliders_.size());
+    colliders_.emplace_back(Collider{}, 0);
+    collider_next_free_.emplace_back(-1);
+    collider_layers_.emplace_back(-1);
+  }
+  return slot;
+}
+
+ColliderIndex World::WriteCollider(const int slot, const ColliderDesc& desc) {
+  auto& [c, generation] = colliders_[slot];
+  c.body = desc.body;
+  c.circle.radius = desc.radius;
+  c.filter = desc.filter;
+  c.solid = desc.solid;
+  ++live_collider_count_;
+  SetLayer(slot);
+  return ColliderIndex{slot, generation};
+}
+
+int World::LayerOf(const CollisionFilter& filter) {
+  for (int k = 0; k < static_cast<int>(layers_.size()); ++k) {
+    if (layers_[k].filter == filter) return k;
+  }
+  Layer& layer = layers_.emplace_back();
+  layer.filter = filter;
+  routes_dirty_ = routes_dirty_ || !category_subscriptions_.empty();
+  if (ShouldCollide(filter, filter)) {
+    layer.broad_phase = MakeBroadPhase(broad_phase_type_, pool_);
+  }
+  return static_cast<int>(layers_.size()) - 1;
+}
+
+void World::SetLayer(const int slot) {
+  // out of its old partition, into the one of its current filter and body
+  const Collider& c = colliders_[slot].first;
+  static_tree_->Remove(slot);
+  if (const int old = collider_layers_[slot]; old >= 0) {
+    if (BroadPhase* broad_phase = layers_[old].broad_phase.get()) broad_phase->Remove(slot);
+  }
+  collider_layers_[slot] = LayerOf(c.filter);
+  if (BroadPhase* partition = PartitionOf(slot)) partition->Insert(slot, ColliderAabb(c));
+  ForgetCollider(slot);
+}
+
+void World::ForgetCollider(const int slot) {
+  // NaN compares unequal to anything: next tick sees it as moved, its
+  // pairs from last tick aren't carried over
+  if (slot < static_cast<int>(collider_x_.size())) {
+    collider_x_[slot] = std::numeric_limits<float>::quiet_NaN();
+  }
+}
+
+void World::FreeCollider(const int slot) {
+  // mark invalid: set body index negative
+  colliders_[slot].first.body = BodyIndex(-1);
+  colliders_[slot].second++;
+  collider_next_free_[slot] = collider_free_head_;
+  collider_free_head_ = slot;
+  --live_collider_count_;
+  static_tree_->Remove(slot);
+  if (BroadPhase* broad_phase = layers_[collider_layers_[slot]].broad_phase.get()) {
+    broad_phase->Remove(slot);
+  }
+  if (!collider_subscriptions_.empty()) prune_subscriptions_ = true;
+}
+
+ColliderIndex World::HandleOf(const int slot) const {
+  return ColliderIndex{slot, colliders_[slot].second};
+}
+
+Aabb World::ColliderAabb(const Collider& c) const {
+  return Aabb::FromCircle(body_positions_[BodySlot(c.body, "get")], c.circle.radius);
+}
+
+BroadPhase* World::PartitionOf(const int slot) const {
+  if (IsStatic(BodySlot(colliders_[slot].first.body, "get"))) return static_tree_.get();
+  return layers_[collider_layers_[slot]].broad_phase.get();
+}
+
+[[nodiscard]] ColliderIndex World::AddCollider(const BodyIndex body, const float radius,
+                                               const CollisionFilter& filter) {
+  return WriteCollider(AllocateCollider(), ColliderDesc{body, radius, filter});
+}
+
+void World::AddColliders(const std::span<const ColliderDesc> descs,
+                         const std::span<ColliderIndex> out) {
+  if (out.size() < descs.size()) {
+    throw std::out_of_range("Trying to add colliders with a too small handle span");
+  }
+  colliders_.reserve(colliders_.size() + descs.size());
+  collider_next_free_.reserve(colliders_.size() + descs.size());
+  collider_layers_.reserve(colliders_.size() + descs.size());
+  for (std::size_t k = 0; k < descs.size(); ++k) {
+    out[k] = WriteCollider(AllocateCollider(), descs[k]);
+  }
+}
+
+[[nodiscard]] Collider& World::GetColliderAt(const ColliderIndex idx) {
+  return colliders_[ColliderSlot(idx, "get")].first;
+}
+
+void World::RemoveCollider(const ColliderIndex idx) {
+  FreeCollider(ColliderSlot(idx, "remove"));
+}
+
+void World::RemoveColliders(const std::span<const ColliderIndex> idxs) {
+  for (const ColliderIndex idx : idxs) FreeCollider(ColliderSlot(idx, "remove"));
+}
+
+DistanceConstraintIndex World::AddDistanceConstraint(const DistanceConstraintDesc& desc) {
+  BodySlot(desc.a, "constrain");
+  BodySlot(desc.b, "constrain");
+  // reuse the last freed slot
+  int slot = distance_free_head_;
+  if (slot >= 0) {
+    distance_free_head_ = distance_next_free_[slot];
+    distance_next_free_[slot] = -1;
+  } else {
+    slot = static_cast<int>(distance_constraints_.size());
+    distance_constraints_.emplace_back(DistanceConstraintDesc{}, 0);
+    distance_next_free_.emplace_back(-1);
+  }
+  distance_constraints_[slot].first = desc;
+  return DistanceConstraintIndex{slot, distance_constraints_[slot].second};
+}
+
+void World::RemoveDistanceConstraint(const DistanceConstraintIndex idx) {
+  if (idx.index() < 0 || idx.index() >= static_cast<int>(distance_constraints_.size())) {
+    throw std::out_of_range("Trying to remove a distance constraint with an out of range index");
+  }
+  auto& [desc, generation] = distance_constraints_[idx.index()];
+  if (idx.generationIndex() != generation) {
+    throw std::runtime_error(
+        "Trying to remove a distance constraint with an invalid generation index");
+  }
+  desc = DistanceConstraintDesc{};
+  ++generation;
+  distance_next_free_[idx.index()] = distance_free_head_;
+  distance_free_head_ = idx.index();
+}
+
+void World::SetContactListener(ContactListener* l) {
+  listener_ = l;
+}
+
+void World::SetContactFilter(ContactFilter* f) {
+  contact_filter_ = f;
+}
+
+void World::SetBroadPhase(const BroadPhaseType type) {
+  broad_phase_type_ = type;
+  for (Layer& layer : layers_) {
+    layer.broad_phase = ShouldCollide(layer.filter, layer.filter)
+                            ? MakeBroadPhase(type, pool_)
+                            : nullptr;
+  }
+  for (int i = 0; i < static_cast<int>(colliders_.size()); ++i) {
+    const Collider& c = colliders_[i].first;
+    if (c.body.index() < 0 || IsStatic(c.body.index())) continue;
+    BroadPhase* broad_phase = layers_[collider_layers_[i]].broad_phase.get();
+    if (broad_phase) broad_phase->Insert(i, ColliderAabb(c));
+  }
+}
+
+BroadPhaseType World::GetBroadPhase() const {
+  return broad_phase_type_;
+}
+
+// ---------- Default world ----------
+World& GetDefaultWorld() {
+  static World world;
+  return world;
+}
+
+[[nodiscard]] BodyIndex AddBody(const float mass, const BodyType type) {
+  return GetDefaultWorld().AddBody(mass, type);
+}
+
+void AddBodies(const std::span<const BodyDesc> descs, const std::span<BodyIndex> out) {
+  GetDefaultWorld().AddBodies(descs, out);
+}
+
+[[nodiscard]] Body get_body_at(const BodyIndex body_index) {
+  return GetDefaultWorld().GetBodyAt(body_index);
+}
+
+void RemoveBody(const BodyIndex body_index) {
+  GetDefaultWorld().RemoveBody(body_index);
+}
+
+void RemoveBodies(const std::span<const BodyIndex> bodies) {
+  GetDefaultWorld().RemoveBodies(bodies);
+}
+
+void SetBodyType(const BodyIndex body_index, const BodyType type) {
+  GetDefaultWorld().SetBodyType(body_index, type);
+}
+
+void Tick(const float dt) {
+  GetDefaultWorld().Tick(dt);
+}
+
+[[nodiscard]] ColliderIndex AddCollider(const BodyIndex body, const float radius,
+                                        const CollisionFilter& filter) {
+  return GetDefaultWorld().AddCollider(body, radius, filter);
+}
+
+void AddColliders(const std::span<const ColliderDesc> descs,
+                  const std::span<ColliderIndex> out) {
+  GetDefaultWorld().AddColliders(descs, out);
 }
 
 [[nodiscard]] Collider& GetColliderAt(const ColliderIndex idx) {
-  if (idx.index() < 0 || idx.index() >= static_cast<int>(colliders.size()))
-    throw std::out_of_range("Trying to get a collider with an out of range index");
-  if (idx.generationIndex() != colliders[idx.index()].second)
-    throw std::runtime_error("Trying to get a collider with an invalid generation index");
-  return colliders[idx.index()].first;
+  return GetDefaultWorld().GetColliderAt(idx);
 }
 
 void RemoveCollider(const ColliderIndex idx) {
-  if (idx.index() < 0 || idx.index() >= static_cast<int>(colliders.size()))
-    throw std::out_of_range("Trying to remove a collider with an out of range index");
-  if (idx.generationIndex() != colliders[idx.index()].second)
-    throw std::runtime_error("Trying to remove a collider with an invalid generation index");
-  // mark invalid: set body index negative
-  colliders[idx.index()].first.body = BodyIndex(-1);
-  colliders[idx.index()].second++;
+  GetDefaultWorld().RemoveCollider(idx);
+}
+
+void RemoveColliders(const std::span<const ColliderIndex> idxs) {
+  GetDefaultWorld().RemoveColliders(idxs);
+}
+
+DistanceConstraintIndex AddDistanceConstraint(const DistanceConstraintDesc& desc) {
+  return GetDefaultWorld().AddDistanceConstraint(desc);
+}
+
+void RemoveDistanceConstraint(const DistanceConstraintIndex idx) {
+  GetDefaultWorld().RemoveDistanceConstraint(idx);
+}
+
+void SetSleepSettings(const SleepSettings& settings) {
+  GetDefaultWorld().SetSleepSettings(settings);
+}
+
+const SleepSettings& GetSleepSettings() {
+  return GetDefaultWorld().GetSleepSettings();
+}
+
+void SetSolverSettings(const SolverSettings& settings) {
+  GetDefaultWorld().SetSolverSettings(settings);
+}
+
+const SolverSettings& GetSolverSettings() {
+  return GetDefaultWorld().GetSolverSettings();
+}
+
+bool IsAwake(const BodyIndex body_index) {
+  return GetDefaultWorld().IsAwake(body_index);
+}
+
+void WakeBody(const BodyIndex body_index) {
+  GetDefaultWorld().WakeBody(body_index);
+}
+
+bool IsOverlapping(const ColliderIndex idx) {
+  return GetDefaultWorld().IsOverlapping(idx);
+}
+
+int OverlapCount(const ColliderIndex idx) {
+  return GetDefaultWorld().OverlapCount(idx);
+}
+
+std::span<const ColliderIndex> GetOverlaps(const ColliderIndex idx) {
+  return GetDefaultWorld().GetOverlaps(idx);
+}
+
+int QueryAABB(const Aabb& aabb, const std::span<ColliderIndex> out,
+              const std::uint32_t categories) {
+  return GetDefaultWorld().QueryAABB(aabb, out, categories);
+}
+
+int QueryCircle(const core::Vec2F center, const float radius,
+                const std::span<ColliderIndex> out, const std::uint32_t categories) {
+  return GetDefaultWorld().QueryCircle(center, radius, out, categories);
+}
+
+int QueryPoint(const core::Vec2F point, const std::span<ColliderIndex> out,
+               const std::uint32_t categories) {
+  return GetDefaultWorld().QueryPoint(point, out, categories);
+}
+
+bool Raycast(const Ray& ray, RayCastHit& hit, const std::uint32_t categories) {
+  return GetDefaultWorld().Raycast(ray, hit, categories);
+}
+
+void QueryAABBs(const std::span<const Aabb> boxes, const std::span<ColliderIndex> out,
+                const std::span<int> counts, const std::uint32_t categories) {
+  GetDefaultWorld().QueryAABBs(boxes, out, counts, categories);
+}
+
+void Raycasts(const std::span<const Ray> rays, const std::span<RayCastHit> hits,
+              const std::uint32_t categories) {
+  GetDefaultWorld().Raycasts(rays, hits, categories);
+}
+
+int KNearest(const core::Vec2F point, const std::span<ColliderIndex> out,
+             const std::uint32_t categories) {
+  return GetDefaultWorld().KNearest(point, out, categories);
 }
 
 void SetContactListener(ContactListener* l) {
-  listener = l;
+  GetDefaultWorld().SetContactListener(l);
+}
+
+void SetContactFilter(ContactFilter* f) {
+  GetDefaultWorld().SetContactFilter(f);
+}
+
+void SetStayEvents(const bool enabled) {
+  GetDefaultWorld().SetStayEvents(enabled);
+}
+
+void SetContinuousCollision(const bool enabled) {
+  GetDefaultWorld().SetContinuousCollision(enabled);
+}
+
+ContactEvents GetContactEvents() {
+  return GetDefaultWorld().GetContactEvents();
+}
+
+void DrainContactEvents(ContactEventBuffer& out) {
+  GetDefaultWorld().DrainContactEvents(out);
+}
+
+void Subscribe(const ColliderIndex collider, ContactListener* listener) {
+  GetDefaultWorld().Subscribe(collider, listener);
+}
+
+void SubscribeCategories(const std::uint32_t categories, ContactListener* listener) {
+  GetDefaultWorld().SubscribeCategories(categories, listener);
+}
+
+void Unsubscribe(ContactListener* listener) {
+  GetDefaultWorld().Unsubscribe(listener);
+}
+
+void SetBroadPhase(const BroadPhaseType type) {
+  GetDefaultWorld().SetBroadPhase(type);
+}
+
+BroadPhaseType GetBroadPhase() {
+  return GetDefaultWorld().GetBroadPhase();
 }
 
 } // namespace common::world
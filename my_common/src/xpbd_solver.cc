@@ -0,0 +1,64 @@
+﻿#include "xpbd_solver.h"
+
+#include <cmath>
+
+namespace common::world {
+namespace {
+// Moves a and b along the unit normal n to bring c, the constraint's
+// error along n, towards 0
+void Project(const XpbdBodies& bodies, const int a, const int b,
+             const core::Vec2F n, const float c, const float alpha) {
+  const float wa = bodies.inverse_mass[a];
+  const float wb = bodies.inverse_mass[b];
+  const float w = wa + wb;
+  if (w <= 0.f) return;
+  const float lambda = -c / (w + alpha);
+  if (wa > 0.f) bodies.position[a] -= n * (lambda * wa);
+  if (wb > 0.f) bodies.position[b] += n * (lambda * wb);
+}
+} // namespace
+
+void PredictPositions(const XpbdBodies& bodies, const int first, const int last,
+                      const float h) {
+  for (int i = first; i < last; ++i) {
+    bodies.previous[i] = bodies.position[i];
+    bodies.velocity[i] += bodies.force[i] * (bodies.inverse_mass[i] * h);
+    bodies.position[i] += bodies.velocity[i] * h;
+  }
+}
+
+void UpdateVelocities(const XpbdBodies& bodies, const int first, const int last,
+                      const float h) {
+  // kinematic bodies keep their exact velocity
+  for (int i = first; i < last; ++i) {
+    if (bodies.inverse_mass[i] <= 0.f) continue;
+    bodies.velocity[i] = (bodies.position[i] - bodies.previous[i]) / h;
+  }
+}
+
+void ProjectContacts(const XpbdBodies& bodies, const std::span<const Contact> contacts,
+                     const float compliance, const float h) {
+  const float alpha = compliance / (h * h);
+  for (const Contact& c : contacts) {
+    const core::Vec2F d = bodies.position[c.b] - bodies.position[c.a];
+    const float distance_sqr = d.magnitude_sqr();
+    if (distance_sqr >= c.radius * c.radius) continue;
+    const float distance = std::sqrt(distance_sqr);
+    const core::Vec2F n = distance > 0.f ? d / distance : core::Vec2F{1.f, 0.f};
+    Project(bodies, c.a, c.b, n, distance - c.radius, alpha);
+  }
+}
+
+void ProjectDistances(const XpbdBodies& bodies,
+                      const std::span<const DistanceConstraint> constraints,
+                      const float h) {
+  for (const DistanceConstraint& c : constraints) {
+    const core::Vec2F d = bodies.position[c.b] - bodies.position[c.a];
+    const float distance = std::sqrt(d.magnitude_sqr());
+    if (distance <= 0.f) continue; // no direction to correct along
+    Project(bodies, c.a, c.b, d / distance, distance - c.length,
+            c.compliance / (h * h));
+  }
+}
+
+} // namespace common::world
@@ -50,6 +50,8 @@ void SolarSystem::Begin() {
   // Création du Soleil
   Planet sun("Sun", {kWidth / 2, kHeight / 2}, {0, 0}, 50, 5000,
              {1.f, 1.f, 0.2f, 1.f});
+  // Le Soleil ne bouge pas : pas d'intégration, sa masse sert à la gravité
+  common::world::SetBodyType(sun.body_idx(), common::BodyType::kStatic);
   AddPlanet(sun);
 
   // Création de la Terre
@@ -67,8 +69,8 @@ void SolarSystem::Begin() {
   // ------------------------------
   // Vitesse orbitale initiale
   // ------------------------------
-  auto& sun_body = common::world::get_body_at(planets_[0].body_idx());
-  auto& earth_body = common::world::get_body_at(planets_[1].body_idx());
+  const auto sun_body = common::world::get_body_at(planets_[0].body_idx());
+  auto earth_body = common::world::get_body_at(planets_[1].body_idx());
 
   core::Vec2F dir = sun_body.position - earth_body.position;
   float       distance = dir.magnitude();
@@ -78,7 +80,7 @@ void SolarSystem::Begin() {
   core::Vec2F tangent = {dir_norm.y, -dir_norm.x};
 
   // Vitesse orbitale équilibrée (ajuste le facteur si nécessaire)
-  const float v = std::sqrt(gravity_ * sun_body.mass / distance);
+  const float v = std::sqrt(gravity_ * sun_body.mass() / distance);
 
   earth_body.Velocity(tangent * v);
 }
@@ -92,11 +94,11 @@ void SolarSystem::Update(const float dt) {
 void SolarSystem::FixedUpdate() {
   // Position du Soleil
   const core::Vec2F pos_sun = common::world::get_body_at(planets_[0].body_idx()).position;
-  const float       mass_sun = common::world::get_body_at(planets_[0].body_idx()).mass;
+  const float       mass_sun = common::world::get_body_at(planets_[0].body_idx()).mass();
 
   // Appliquer la gravité pour chaque planète
   for (int i = 1; i < planets_.size(); ++i) {
-    const float       planet_mass = common::world::get_body_at(planets_[i].body_idx()).mass;
+    const float       planet_mass = common::world::get_body_at(planets_[i].body_idx()).mass();
     const core::Vec2F pos_planet = common::world::get_body_at(planets_[i].body_idx()).position;
 
     core::Vec2F dir = pos_sun - pos_planet; // vecteur vers le Soleil
@@ -0,0 +1,198 @@
+﻿#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "world.h"
+
+// ------------------- BROADPHASE BENCHMARK -------------------
+// Headless: times common::world::Tick for every broadphase on the same
+// random scene (constant density, radii 1..10, speeds up to 100 units/s),
+// once in a single layer and once split in two layers that also collide
+// with each other, so that the pairs across layers are timed too.
+// Up to kMaxBruteForceCount, every broadphase must also give the same
+// enters and exits as brute force on every tick, or the bench fails.
+namespace bench {
+struct Scene {
+  std::vector<common::world::BodyIndex>     bodies;
+  std::vector<common::world::ColliderIndex> colliders;
+};
+
+// Enters and exits of one tick. The digest is a sum, so it doesn't
+// depend on the order of the events
+struct TickPairs {
+  int           enters = 0;
+  int           exits = 0;
+  std::uint64_t digest = 0;
+
+  bool operator==(const TickPairs&) const = default;
+};
+
+// Records the events by scene index: the free list hands the slots back
+// in another order from one run to the next
+class PairRecorder final : public common::world::ContactListener {
+public:
+  explicit PairRecorder(const Scene& scene) {
+    for (std::size_t i = 0; i < scene.colliders.size(); ++i) {
+      const auto slot = static_cast<std::size_t>(scene.colliders[i].index());
+      if (slot >= scene_index_.size()) scene_index_.resize(slot + 1, -1);
+      scene_index_[slot] = static_cast<int>(i);
+    }
+  }
+
+  void OnContactEvents(const common::world::ContactEvents& events) override {
+    TickPairs tick;
+    tick.enters = static_cast<int>(events.enters.size());
+    tick.exits = static_cast<int>(events.exits.size());
+    for (const auto& e : events.enters) tick.digest += Mix(Key(e));
+    for (const auto& e : events.exits) tick.digest += Mix(~Key(e));
+    ticks_.push_back(tick);
+  }
+
+  [[nodiscard]] const std::vector<TickPairs>& ticks() const { return ticks_; }
+
+private:
+  std::uint64_t Key(const common::world::ContactEvent& e) const {
+    const int a = scene_index_[static_cast<std::size_t>(e.a.index())];
+    const int b = scene_index_[static_cast<std::size_t>(e.b.index())];
+    return static_cast<std::uint64_t>(std::min(a, b)) << 32 |
+           static_cast<std::uint32_t>(std::max(a, b));
+  }
+
+  // splitmix64 finalizer
+  static std::uint64_t Mix(std::uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+  }
+
+  std::vector<int>       scene_index_;
+  std::vector<TickPairs> ticks_;
+};
+
+Scene CreateScene(const int count, const unsigned seed, const bool two_layers) {
+  // ~ 1 body per 400 units², same density whatever the count
+  const float half_size = std::sqrt(static_cast<float>(count) * 400.f) * 0.5f;
+  std::mt19937 rng{seed};
+  std::uniform_real_distribution<float> pos(-half_size, half_size);
+  std::uniform_real_distribution<float> vel(-100.f, 100.f);
+  std::uniform_real_distribution<float> rad(1.f, 10.f);
+
+  const auto size = static_cast<std::size_t>(count);
+  std::vector<common::world::BodyDesc> bodies(size);
+  std::vector<float>                   radii(size);
+  for (std::size_t i = 0; i < size; ++i) {
+    bodies[i].position = {pos(rng), pos(rng)};
+    bodies[i].velocity = {vel(rng), vel(rng)};
+    radii[i] = rad(rng);
+  }
+
+  Scene scene;
+  scene.bodies.resize(size, common::world::BodyIndex{-1});
+  common::world::AddBodies(bodies, scene.bodies);
+  std::vector<common::world::ColliderDesc> colliders(size);
+  for (std::size_t i = 0; i < size; ++i) {
+    colliders[i].body = scene.bodies[i];
+    colliders[i].radius = radii[i];
+    // categories 1 and 2, each colliding with both
+    if (two_layers) colliders[i].filter = {i % 2 == 0 ? 1u : 2u, 3u};
+  }
+  scene.colliders.resize(size, common::world::ColliderIndex{-1});
+  common::world::AddColliders(colliders, scene.colliders);
+  return scene;
+}
+
+void DestroyScene(const Scene& scene) {
+  common::world::RemoveColliders(scene.colliders);
+  common::world::RemoveBodies(scene.bodies);
+}
+
+const char* Name(const common::world::BroadPhaseType type) {
+  switch (type) {
+    case common::world::BroadPhaseType::kBruteForce: return "brute force";
+    case common::world::BroadPhaseType::kSpatialHash: return "spatial hash";
+    case common::world::BroadPhaseType::kSweepAndPrune: return "sweep and prune";
+    case common::world::BroadPhaseType::kDynamicTree: return "dynamic tree";
+    case common::world::BroadPhaseType::kLinearBvh: return "linear bvh";
+    case common::world::BroadPhaseType::kHierarchicalGrid: return "hierarchical grid";
+  }
+  return "?";
+}
+
+// Returns the events of every tick, the first one included
+std::vector<TickPairs> Run(const common::world::BroadPhaseType type,
+                           const int count, const int ticks, const bool two_layers) {
+  common::world::SetBroadPhase(type);
+  const Scene scene = CreateScene(count, 1234u, two_layers);
+  PairRecorder recorder(scene);
+  common::world::SetContactListener(&recorder);
+  common::world::Tick(0.016f); // premier tick: construction des structures
+
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < ticks; ++i) common::world::Tick(0.016f);
+  const auto end = std::chrono::steady_clock::now();
+
+  const double ms = std::chrono::duration<double, std::milli>(end - start).count();
+  std::printf("%-18s %8d colliders %-10s %10.3f ms/tick\n", Name(type), count,
+              two_layers ? "2 layers" : "1 layer", ms / ticks);
+  common::world::SetContactListener(nullptr);
+  DestroyScene(scene);
+  common::world::Tick(0.016f); // vide les paires actives
+  return recorder.ticks();
+}
+
+// First tick where the pairs differ, -1 if none
+int FirstMismatch(const std::vector<TickPairs>& reference,
+                  const std::vector<TickPairs>& pairs) {
+  const std::size_t size = std::min(reference.size(), pairs.size());
+  for (std::size_t i = 0; i < size; ++i) {
+    if (!(reference[i] == pairs[i])) return static_cast<int>(i);
+  }
+  return reference.size() == pairs.size() ? -1 : static_cast<int>(size);
+}
+} // namespace bench
+
+// ------------------- MAIN -------------------
+// broadphase_bench [max_count] [ticks]
+int main(const int argc, char** argv) {
+  const int max_count = argc > 1 ? std::atoi(argv[1]) : 100000;
+  const int ticks = argc > 2 ? std::atoi(argv[2]) : 20;
+
+  constexpr common::world::BroadPhaseType kTypes[] = {
+      common::world::BroadPhaseType::kBruteForce,
+      common::world::BroadPhaseType::kSpatialHash,
+      common::world::BroadPhaseType::kSweepAndPrune,
+      common::world::BroadPhaseType::kDynamicTree,
+      common::world::BroadPhaseType::kLinearBvh,
+      common::world::BroadPhaseType::kHierarchicalGrid,
+  };
+  // Brute force is skipped past this count, it would take minutes
+  constexpr int kMaxBruteForceCount = 10000;
+
+  bool failed = false;
+  for (int count = 1000; count <= max_count; count *= 10) {
+    for (const bool two_layers : {false, true}) {
+      std::vector<bench::TickPairs> reference; // brute force, run first
+      for (const auto type : kTypes) {
+        if (type == common::world::BroadPhaseType::kBruteForce &&
+            count > kMaxBruteForceCount)
+          continue;
+        const auto pairs = bench::Run(type, count, ticks, two_layers);
+        if (type == common::world::BroadPhaseType::kBruteForce) {
+          reference = pairs;
+        } else if (!reference.empty()) {
+          if (const int tick = bench::FirstMismatch(reference, pairs); tick >= 0) {
+            std::fprintf(stderr, "%s, %s: pairs differ from brute force at tick %d\n",
+                         bench::Name(type), two_layers ? "2 layers" : "1 layer", tick);
+            failed = true;
+          }
+        }
+      }
+    }
+  }
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,157 @@
+﻿#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <string_view>
+
+#include "thread_pool.h"
+#include "work_stealing_pool.h"
+#include "world.h"
+
+// ------------------- ENSEMBLE RUNNER -------------------
+// Headless: runs a scenario once per perturbation seed, each run in its own
+// World, spread over a work-stealing pool, and writes one CSV line of
+// summary metrics per run as soon as it finishes.
+namespace ensemble {
+struct RunResult {
+  unsigned seed = 0;
+  int      steps = 0;
+  double   energy_drift = 0.0;     // |E_end - E_0| / |E_0|
+  double   max_energy_drift = 0.0; // worst |E - E_0| / |E_0| over the run
+  double   min_distance = std::numeric_limits<double>::max();
+  double   max_distance = 0.0;
+  double   ms = 0.0;
+};
+
+using Scenario = RunResult (*)(unsigned seed, int steps);
+
+// Same setup as solar_system.cc: static sun of 5000 in the middle of the 1700x900
+// window, earth of 10 at 200 units on the circular orbit, G = 250, fixed
+// step of the engine. The seed perturbs the earth's start by ~1%.
+RunResult RunSolar(const unsigned seed, const int steps) {
+  constexpr float       kGravity = 250.f;
+  constexpr float       kDt = 0.016f;
+  constexpr float       kSunMass = 5000.f;
+  constexpr float       kEarthMass = 10.f;
+  constexpr core::Vec2F kSunPosition = {1700.f / 2, 900.f / 2};
+
+  std::mt19937                    rng{seed};
+  std::normal_distribution<float> perturbation(0.f, 0.01f);
+
+  // Runs are already spread over the cores, each world ticks on its own
+  // thread only
+  common::ThreadPool    serial(0);
+  common::world::World  world(serial);
+  const common::world::BodyIndex sun_index = world.AddBody(kSunMass);
+  const common::world::BodyIndex earth_index = world.AddBody(kEarthMass);
+  world.GetBodyAt(sun_index).position = kSunPosition;
+  // static, as in solar_system.cc: its mass only feeds the gravity
+  world.SetBodyType(sun_index, common::BodyType::kStatic);
+
+  const float       angle = perturbation(rng);
+  const float       radius = 200.f * (1.f + perturbation(rng));
+  const core::Vec2F offset = {radius * std::cos(angle), radius * std::sin(angle)};
+  auto              earth = world.GetBodyAt(earth_index);
+  earth.position = kSunPosition + offset;
+  // Vecteur tangent (orbite antihoraire)
+  const core::Vec2F dir_norm = offset / -radius;
+  const core::Vec2F tangent = {dir_norm.y, -dir_norm.x};
+  const float       v = std::sqrt(kGravity * kSunMass / radius);
+  earth.Velocity(tangent * (v * (1.f + perturbation(rng))));
+
+  const auto energy = [&] {
+    const auto   e = world.GetBodyAt(earth_index);
+    const auto   s = world.GetBodyAt(sun_index);
+    const double distance = (s.position - e.position).magnitude();
+    const double speed2 = e.velocity().magnitude_sqr();
+    return 0.5 * kEarthMass * speed2 -
+           static_cast<double>(kGravity) * kSunMass * kEarthMass / distance;
+  };
+
+  RunResult  result;
+  result.seed = seed;
+  result.steps = steps;
+  const auto start = std::chrono::steady_clock::now();
+  const double initial_energy = energy();
+  for (int i = 0; i < steps; ++i) {
+    // Même force que SolarSystem::FixedUpdate, le Soleil n'est pas attiré
+    auto              e = world.GetBodyAt(earth_index);
+    const core::Vec2F dir = world.GetBodyAt(sun_index).position - e.position;
+    const float       distance = dir.magnitude();
+    if (distance > 1e-4f) {
+      const float force_mag = kGravity * kEarthMass * kSunMass / (distance * distance);
+      e.AddForce(dir / distance * force_mag);
+    }
+    world.Tick(kDt);
+
+    const double d = (world.GetBodyAt(sun_index).position -
+                      world.GetBodyAt(earth_index).position).magnitude();
+    result.min_distance = std::min(result.min_distance, d);
+    result.max_distance = std::max(result.max_distance, d);
+    const double drift = std::abs(energy() - initial_energy) / std::abs(initial_energy);
+    result.max_energy_drift = std::max(result.max_energy_drift, drift);
+    result.energy_drift = drift;
+  }
+  result.ms = std::chrono::duration<double, std::milli>(
+                  std::chrono::steady_clock::now() - start).count();
+  return result;
+}
+
+Scenario FindScenario(const std::string_view name) {
+  if (name == "solar") return RunSolar;
+  return nullptr;
+}
+} // namespace ensemble
+
+// ------------------- MAIN -------------------
+// ensemble <scenario> <runs> [steps] [first_seed] [out.csv]
+// scenario: solar. Without a file the CSV goes to stdout.
+int main(const int argc, char** argv) {
+  if (argc < 3) {
+    std::fprintf(stderr,
+                 "usage: %s <scenario> <runs> [steps] [first_seed] [out.csv]\n",
+                 argv[0]);
+    return 1;
+  }
+  const ensemble::Scenario scenario = ensemble::FindScenario(argv[1]);
+  if (!scenario) {
+    std::fprintf(stderr, "unknown scenario '%s' (available: solar)\n", argv[1]);
+    return 1;
+  }
+  const int      runs = std::atoi(argv[2]);
+  const int      steps = argc > 3 ? std::atoi(argv[3]) : 10000;
+  const unsigned first_seed = argc > 4 ? static_cast<unsigned>(std::atoi(argv[4])) : 0u;
+  std::FILE*     out = argc > 5 ? std::fopen(argv[5], "w") : stdout;
+  if (!out) {
+    std::fprintf(stderr, "can't open %s\n", argv[5]);
+    return 1;
+  }
+
+  std::fprintf(out, "seed,steps,energy_drift,max_energy_drift,min_distance,"
+                    "max_distance,ms\n");
+  std::mutex out_mutex;
+
+  common::WorkStealingPool pool;
+  const auto               start = std::chrono::steady_clock::now();
+  for (int i = 0; i < runs; ++i) {
+    const unsigned seed = first_seed + static_cast<unsigned>(i);
+    pool.Submit([&, seed] {
+      const ensemble::RunResult r = scenario(seed, steps);
+      std::scoped_lock lock(out_mutex);
+      std::fprintf(out, "%u,%d,%.9g,%.9g,%.9g,%.9g,%.3f\n", r.seed, r.steps,
+                   r.energy_drift, r.max_energy_drift, r.min_distance,
+                   r.max_distance, r.ms);
+      std::fflush(out);
+    });
+  }
+  pool.Wait();
+  const double ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start).count();
+  std::fprintf(stderr, "%d runs on %d threads in %.1f ms (%.1f runs/s)\n",
+               runs, pool.thread_count(), ms, runs * 1000.0 / ms);
+  if (out != stdout) std::fclose(out);
+}
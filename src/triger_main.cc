@@ -13,8 +13,9 @@
 // ------------------- COLLIDER SYSTEM -------------------
 namespace collider {
 struct Circle {
-  common::world::BodyIndex body_index;
-  float                    radius;
+  common::world::BodyIndex     body_index;
+  common::world::ColliderIndex collider_index;
+  float                        radius;
   float                    r, g, b, a;
 };
 
@@ -28,21 +29,44 @@ public:
     std::uniform_real_distribution<float> velDist(-1.f, 1.f);
     std::uniform_real_distribution<float> radDist(minRadius_, maxRadius_);
 
-    for (int i = 0; i < circleCount_; ++i) {
-      float                    radius = radDist(rng_);
-      common::world::BodyIndex b = common::world::AddBody(1.f);
-      auto&                    body = common::world::get_body_at(b);
-      body.position = {posX(rng_), posY(rng_)};
-      body.Velocity({velDist(rng_) * maxSpeed_, velDist(rng_) * maxSpeed_});
+    const auto count = static_cast<std::size_t>(circleCount_);
+    std::vector<common::world::BodyDesc> descs(count);
+    std::vector<float>                   radii(count);
+    for (std::size_t i = 0; i < count; ++i) {
+      radii[i] = radDist(rng_);
+      descs[i].position = {posX(rng_), posY(rng_)};
+      descs[i].velocity = {velDist(rng_) * maxSpeed_, velDist(rng_) * maxSpeed_};
+    }
 
-      circles_.push_back({b, radius, 1.f, 0.f, 0.f, 1.f});
+    // jusqu'à 500 unités/s pour des rayons de 1 : balayage continu
+    common::world::SetContinuousCollision(true);
+    // les cercles rebondissent entre eux
+    common::world::SolverSettings solver;
+    solver.restitution = 1.f;
+    common::world::SetSolverSettings(solver);
+
+    // tous les corps en un seul appel
+    std::vector<common::world::BodyIndex> bodies(count, common::world::BodyIndex{-1});
+    common::world::AddBodies(descs, bodies);
+
+    // un collider solide par corps, contacts et rebonds résolus par le monde
+    std::vector<common::world::ColliderDesc> collider_descs(count);
+    for (std::size_t i = 0; i < count; ++i) {
+      collider_descs[i].body = bodies[i];
+      collider_descs[i].radius = radii[i];
+      collider_descs[i].solid = true;
+    }
+    std::vector<common::world::ColliderIndex> colliders(count, common::world::ColliderIndex{-1});
+    common::world::AddColliders(collider_descs, colliders);
+    for (std::size_t i = 0; i < count; ++i) {
+      circles_.push_back({bodies[i], colliders[i], radii[i], 1.f, 0.f, 0.f, 1.f});
     }
   }
 
   void Update(float dt) override {
     // Déplacement et rebond
     for (auto& c : circles_) {
-      auto& body = common::world::get_body_at(c.body_index);
+      auto body = common::world::get_body_at(c.body_index);
       auto  vel = body.velocity();
       float r = c.radius;
 
@@ -65,26 +89,15 @@ public:
       body.Velocity(vel);
     }
 
-    // Détection de collision simple (triggers)
-    for (auto& c : circles_) c.r = 1.f, c.g = 0.f, c.b = 0.f;
-    for (size_t i = 0; i < circles_.size(); ++i) {
-      auto& b1 = common::world::get_body_at(circles_[i].body_index);
-      for (size_t j = i + 1; j < circles_.size(); ++j) {
-        auto& b2 = common::world::get_body_at(circles_[j].body_index);
-        float dist2 = (b1.position - b2.position).magnitude_sqr();
-        float radiusSum = circles_[i].radius + circles_[j].radius;
-        if (dist2 <= radiusSum * radiusSum) {
-          circles_[i].r = 0.f;
-          circles_[i].g = 1.f;
-          circles_[i].b = 0.f;
-          circles_[j].r = 0.f;
-          circles_[j].g = 1.f;
-          circles_[j].b = 0.f;
-        }
-      }
-    }
-
     common::world::Tick(dt);
+
+    // Couleur selon l'état des triggers calculé par le Tick
+    for (auto& c : circles_) {
+      const bool overlapping = common::world::IsOverlapping(c.collider_index);
+      c.r = overlapping ? 0.f : 1.f;
+      c.g = overlapping ? 1.f : 0.f;
+      c.b = 0.f;
+    }
   }
 
   void FixedUpdate() override {
@@ -95,7 +108,7 @@ public:
 
   void Draw() override {
     for (auto& c : circles_) {
-      auto& body = common::world::get_body_at(c.body_index);
+      auto body = common::world::get_body_at(c.body_index);
       common::DrawCircle(body.position.x, body.position.y, c.radius,
                          SDL_FColor{c.r, c.g, c.b, c.a});
     }
@@ -123,10 +136,17 @@ public:
     ImGui::End();
 
     if (changed) {
-      // supprimer les corps existants
-      for (auto& c : circles_) {
-        common::world::RemoveBody(c.body_index);
+      // supprimer les colliders et corps existants
+      std::vector<common::world::BodyIndex>     bodies;
+      std::vector<common::world::ColliderIndex> colliders;
+      bodies.reserve(circles_.size());
+      colliders.reserve(circles_.size());
+      for (const auto& c : circles_) {
+        bodies.push_back(c.body_index);
+        colliders.push_back(c.collider_index);
       }
+      common::world::RemoveColliders(colliders);
+      common::world::RemoveBodies(bodies);
       circles_.clear();
 
       // recréer les corps avec les nouvelles valeurs